@@ -6,7 +6,10 @@
 Clock::Clock()
 {
     connectToClockEngines();
-    useSampleClock();
+
+    if (sampleClock.hasOutputDevice())
+         useSampleClock();
+    else useSystemClock();
 }
 
 void Clock::connect(ClockListener* listener)
@@ -27,26 +30,30 @@ void Clock::disconnect(ClockListener* listener)
 
 void Clock::useSampleClock()
 {
-    if (usingSampleClock)
-        return;
-    
-    const bool isTicking = midiClock.clockIsTicking();
-    
-    midiClock.setClockShouldTick(false);
-    sampleClock.setClockShouldTick(isTicking);
-    
-    usingSampleClock = true;
+    use(ClockSource::Sample);
+}
+
+void Clock::useSystemClock()
+{
+    use(ClockSource::System);
 }
 
 void Clock::useMidiClock()
 {
-    if (!usingSampleClock)
+    use(ClockSource::MIDI);
+}
+
+void Clock::use(ClockSource source)
+{
+    if (this->source.load() == source)
         return;
     
-    const bool isTicking = midiClock.clockIsTicking();
-
-    sampleClock.setClockShouldTick(false);
-    midiClock.setClockShouldTick(isTicking);
+    ClockEngine * const current = getClockEngine(this->source.load());
+    ClockEngine * const next    = getClockEngine(source);
+    const bool isTicking = current->clockIsTicking();
+    
+    current->setClockShouldTick(false);
+    next->setClockShouldTick(isTicking);
     
-    usingSampleClock = false;
+    this->source.store(source);
 }
@@ -4,14 +4,22 @@
 #ifndef CLOCK_H
 #define CLOCK_H
 
+#include <atomic>
 #include "ClockListener.h"
 #include "SampleClock.h"
+#include "SystemClock.h"
 #include "MIDIClock.h"
+#include "MIDIClockOutput.h"
 
-/// @brief A clock that contains both an internal audio rate clock engine and an external MIDI clock engine.
+/// @brief Constants defining the clock engines that can drive the clock.
+
+enum class ClockSource { Sample, System, MIDI };
+
+/// @brief A clock that contains an internal audio rate clock engine, an internal system clock engine, and an external MIDI clock engine.
 ///
 /// This clock can be used by subclassing ClockListener, overriding the virtual `tick` method, and connecting to the clock.
 /// The `tick` method will be called whenever the chosen clock engine ticks.
+/// While an internal clock engine is in use, the clock can also act as a MIDI clock master on a chosen output port.
 
 class Clock: public ClockListener
 {
@@ -19,14 +27,19 @@ public:
     Clock();
     
 public:
-    inline void tick() override
+    inline void tick(const ClockTick& tick) override
     {
         for (ClockListener* listener : listeners)
         {
-            listener->tick();
+            listener->tick(tick);
         }
     }
     
+    inline void pulse(const ClockTick& pulse) override
+    {
+        clockOutput.pulse(pulse.timestamp);
+    }
+    
 public:
     /// @brief Connect a new listener, who will subsequently receive notifications when the clock ticks.
     /// @param listener The listener who should be connected.
@@ -43,17 +56,35 @@ public:
 
     void useSampleClock();
     
+    /// @brief Use the underlying system clock, which requires no sound device, as the clock source.
+
+    void useSystemClock();
+    
     /// @brief Use the underlying MIDI clock listener as the clock source.
 
     void useMidiClock();
     
+    /// @brief Return the clock source that's currently in use.
+
+    inline ClockSource getClockSource() const noexcept
+    {
+        return source.load();
+    }
+    
 // MARK: - Global Clock Interface
 public:
     /// @brief Toggle the `ticking` state of the selected clock source.
 
     inline void toggleClock() noexcept
     {
-        (*getClockEngine()).toggleClock();
+        setClockShouldTick(!clockIsTicking());
+    }
+    
+    /// @brief Get the `ticking` state of the selected clock source.
+
+    inline bool clockIsTicking() noexcept
+    {
+        return (*getClockEngine()).clockIsTicking();
     }
     
     /// @brief Set the `ticking` state of the selected clock source explicitly.
@@ -61,7 +92,18 @@ public:
 
     inline void setClockShouldTick(bool shouldTick) noexcept
     {
-        (*getClockEngine()).setClockShouldTick(shouldTick);
+        ClockEngine * const engine = getClockEngine();
+
+        if (engine->clockIsTicking() == shouldTick)
+            return;
+
+        if (shouldTick)
+            clockOutput.start();
+
+        engine->setClockShouldTick(shouldTick);
+
+        if (!shouldTick)
+            clockOutput.stop();
     }
     
     /// @brief Get the tempo of the clock.
@@ -79,13 +121,14 @@ public:
         return (*getClockEngine()).getSubdivision();
     }
     
-    /// @brief Set the tempo of the internal clock engine.
+    /// @brief Set the tempo of the internal clock engines.
     /// @param beatsPerMinute The desired tempo in beats per minute.
     /// @note  The tempo of the external MIDI clock should be set at the source.
 
     inline void setTempo(unsigned int beatsPerMinute) noexcept
     {
         sampleClock.setTempo(beatsPerMinute);
+        systemClock.setTempo(beatsPerMinute);
     }
     
     /// @brief Set the time subdivision of all underlying clock engines.
@@ -108,6 +151,72 @@ public:
     }
     
     
+// MARK: - System Clock Interface
+    
+public:
+    /// @brief Request that the underlying system clock's timer thread be scheduled with a real-time policy.
+    /// @param shouldUseRealtimePriority Whether the timer thread should use a real-time scheduling policy or not.
+
+    inline void setSystemClockUsesRealtimePriority(bool shouldUseRealtimePriority) noexcept
+    {
+        systemClock.setUsesRealtimePriority(shouldUseRealtimePriority);
+    }
+    
+// MARK: - MIDI Clock Output Interface
+    
+public:
+    /// @brief Enable or disable the MIDI clock output, which sends 24-PPQN clock pulses, Start, Continue, Stop, and Song Position Pointer messages.
+    /// @param shouldBeEnabled Whether the MIDI clock output should be enabled or not.
+    /// @note  Pulses are only sent while an internal clock engine is in use.
+
+    inline void setMIDIClockOutputEnabled(bool shouldBeEnabled) noexcept
+    {
+        clockOutput.setEnabled(shouldBeEnabled);
+    }
+    
+    /// @brief Indicate whether the MIDI clock output is enabled or not.
+
+    inline bool midiClockOutputIsEnabled() const noexcept
+    {
+        return clockOutput.isEnabled();
+    }
+    
+    /// @brief Select the given MIDI port for the MIDI clock output.
+    /// @param port The number of the port to be opened.
+
+    inline bool selectMIDIClockOutputPort(unsigned int port) noexcept
+    {
+        return clockOutput.selectMIDIPort(port);
+    }
+    
+    /// @brief Select the next of the available MIDI ports for the MIDI clock output.
+
+    inline void selectNextMIDIClockOutputPort() noexcept
+    {
+        clockOutput.selectNextMIDIPort();
+    }
+    
+    /// @brief Select the previous of the available MIDI ports for the MIDI clock output.
+
+    inline void selectPreviousMIDIClockOutputPort() noexcept
+    {
+        clockOutput.selectPreviousMIDIPort();
+    }
+    
+    /// @brief Return the MIDI clock output's port.
+
+    inline unsigned int getMIDIClockOutputPort() noexcept
+    {
+        return clockOutput.getMIDIPort();
+    }
+    
+    /// @brief Return a textual description of the MIDI clock output's port.
+
+    inline std::string getMIDIClockOutputPortDescription() noexcept
+    {
+        return clockOutput.getMIDIPortDescription();
+    }
+    
 // MARK: - MIDI Clock Interface
     
 public:
@@ -152,23 +261,50 @@ private:
 
     inline ClockEngine * getClockEngine() noexcept
     {
-        if (usingSampleClock)
-             return &sampleClock;
-        else return &midiClock;
+        return getClockEngine(source.load());
+    }
+    
+    /// @brief Return a pointer to the clock engine corresponding to the given clock source.
+    /// @param source The clock source.
+
+    inline ClockEngine * getClockEngine(ClockSource source) noexcept
+    {
+        switch (source)
+        {
+            case ClockSource::Sample: return &sampleClock;
+            case ClockSource::System: return &systemClock;
+            case ClockSource::MIDI:   return &midiClock;
+        }
+
+        return &sampleClock;
     }
     
     inline void connectToClockEngines() noexcept
     {
         midiClock.connect(this);
         sampleClock.connect(this);
+        systemClock.connect(this);
     }
+    
+    /// @brief Stop the clock engine that's currently in use and transfer its ticking state to the given clock source.
+    /// @param source The clock source that should be used.
+
+    void use(ClockSource source);
 
 private:
-    bool usingSampleClock;
+    /// @brief The clock source that's currently in use, which is read by the thread that ticks the clock's listeners.
+
+    std::atomic<ClockSource> source = {ClockSource::Sample};
     
+private:
+    /// @brief The MIDI clock output, which is declared before the clock engines so that it outlives their threads.
+
+    MIDIClockOutput clockOutput;
+
 private:
     MIDIClock   midiClock;
     SampleClock sampleClock;
+    SystemClock systemClock;
 
 private:
     std::vector<ClockListener*> listeners;
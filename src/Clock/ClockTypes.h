@@ -4,8 +4,10 @@
 #ifndef CLOCKTYPES_H
 #define CLOCKTYPES_H
 
+#include "ClockTick.h"
 #include "ClockListener.h"
 #include "SampleClock.h"
+#include "SystemClock.h"
 #include "MIDIClock.h"
 
 #endif
@@ -4,7 +4,9 @@
 #ifndef CLOCKENGINE_H
 #define CLOCKENGINE_H
 
+#include <atomic>
 #include "ofMain.h"
+#include "ClockGrid.h"
 #include "ClockListener.h"
 
 class ClockEngine
@@ -46,17 +48,18 @@ public:
     }
     
     /// @brief Get the `ticking` state of the clock.
+    /// @note  This can be called from any thread. A listener may still be processing a tick after the state has been cleared.
 
     inline bool clockIsTicking() const noexcept
     {
-        return ticking;
+        return ticking.load();
     }
     
     /// @brief Toggle the clock's ticking state.
 
     virtual inline void toggleClock() noexcept
     {
-        ticking = !ticking;
+        ticking.store(!ticking.load());
     }
     
     /// @brief Set the clock's ticking state explicitly.
@@ -64,7 +67,7 @@ public:
 
     virtual inline void setClockShouldTick(bool shouldTick) noexcept
     {
-        ticking = shouldTick;
+        ticking.store(shouldTick);
     }
     
     /// @brief Get the clock's tempo in beats per minute.
@@ -75,6 +78,7 @@ public:
     }
     
     /// @brief Get the clock's time subdivision.
+    /// @note  Each playhead moves at its own multiple and division of this subdivision. See `EnginePlayhead::setRate`.
 
     virtual inline int getSubdivision() const noexcept
     {
@@ -92,6 +96,8 @@ public:
         
         tempo = std::max(beatsPerMinute, (unsigned int) ClockEngine::MINIMUM_TEMPO);
         tempo = std::min(tempo,          (unsigned int) ClockEngine::MAXIMUM_TEMPO);
+
+        gridTempo.store(tempo);
     }
 
     /// @brief Set the clock's time subdivision.
@@ -105,31 +111,77 @@ public:
 
         subdivision = std::max(ticksPerBeat, (unsigned int) ClockEngine::MINIMUM_SUBDIVISION);
         subdivision = std::min(subdivision,  (unsigned int) ClockEngine::MAXIMUM_SUBDIVISION);
+
+        gridSubdivision.store(subdivision);
     }
     
 protected:
 
     /// @brief Broadcast a notification to all connected listeners.
+    /// @param tick A description of the moment at which the tick should be realised.
 
-    inline void tick()
+    inline void tick(const ClockTick& tick)
     {
         for (ClockListener* listener : listeners)
         {
-            listener->tick();
+            listener->tick(tick);
         }
     }
 
+    /// @brief Broadcast a MIDI clock pulse to all connected listeners.
+    /// @param pulse A description of the moment at which the pulse should be realised.
+
+    inline void pulse(const ClockTick& pulse)
+    {
+        for (ClockListener* listener : listeners)
+        {
+            listener->pulse(pulse);
+        }
+    }
+
+    /// @brief Realise the next step of the beat grid, broadcasting a pulse and a tick if either falls on it, and advance to the following step.
+    /// @param time A description of the moment at which the step should be realised.
+    /// @note  This should only be called by the thread that drives an internal clock engine.
+
+    inline void step(const ClockTick& time)
+    {
+        if (grid.isPulse())
+            pulse(time);
+
+        if (grid.isTick())
+            tick(time);
+
+        grid.advance(gridSubdivision.load(std::memory_order_relaxed));
+    }
+
+    /// @brief Indicate whether a pulse or a tick falls on the next step of the beat grid.
+
+    inline bool stepHasEvents() const noexcept
+    {
+        return grid.isPulse() || grid.isTick();
+    }
+
+    /// @brief Compute the number of beat grid steps per minute, which is the denominator of the step length in any unit of time.
+    /// @note  Changes in tempo and subdivision take effect at the next step boundary.
+
+    inline uint64_t getStepsPerMinute() const noexcept
+    {
+        return gridTempo.load(std::memory_order_relaxed) * grid.resolution;
+    }
+
 protected:
-    bool ticking;
+    /// @brief Whether the clock is ticking, which is written by the UI thread and read by the thread that drives the clock.
+
+    std::atomic<bool> ticking = {false};
+
+protected:
+    /// @brief The steps within each beat on which ticks and pulses fall, which is owned by the thread that drives the engine.
+
+    ClockGrid grid;
     
 protected:
     unsigned int tempo;
     unsigned int subdivision;
-    
-/// Consider moving subdivisions into SQPlayhead:
-///   - i.e., Playhead moves once every `n` ticks
-///   - This allows for more complex rhythms
-/// Alternatively duplicate subdivisions in SQPlayhead and retain a global subdivision.
 
 protected:
     constexpr static unsigned int MINIMUM_TEMPO = 5;
@@ -137,6 +189,10 @@ protected:
     constexpr static unsigned int MINIMUM_SUBDIVISION = 1;
     constexpr static unsigned int MAXIMUM_SUBDIVISION = 7;
 
+private:
+    std::atomic<unsigned int> gridTempo = {120};
+    std::atomic<unsigned int> gridSubdivision = {4};
+
 private:
     std::vector<ClockListener*> listeners;
 };
@@ -0,0 +1,74 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef CLOCKGRID_H
+#define CLOCKGRID_H
+
+#include <cstdint>
+#include <numeric>
+
+/// @brief A grid of evenly spaced steps within each beat, on which both the clock's ticks and its 24-PPQN MIDI clock pulses fall.
+/// @note  Each beat is divided into `lcm(24, subdivision)` steps, so every tick and every pulse coincides with a step exactly
+///        and the two never drift apart, regardless of the subdivision. The grid is owned by the thread that realises the steps.
+
+struct ClockGrid
+{
+    /// @brief The number of MIDI clock pulses per beat.
+
+    constexpr static uint64_t PULSES_PER_BEAT = 24;
+
+    /// @brief The index of the next step within the current beat.
+
+    uint64_t position = 0;
+
+    /// @brief The number of ticks per beat.
+
+    uint64_t subdivision = 1;
+
+    /// @brief The number of steps per beat.
+
+    uint64_t resolution = PULSES_PER_BEAT;
+
+    /// @brief Indicate whether a clock pulse falls on the next step.
+
+    inline bool isPulse() const noexcept
+    {
+        return position % (resolution / PULSES_PER_BEAT) == 0;
+    }
+
+    /// @brief Indicate whether a tick falls on the next step.
+
+    inline bool isTick() const noexcept
+    {
+        return position % (resolution / subdivision) == 0;
+    }
+
+    /// @brief Advance to the following step after the next step has been realised.
+    /// @param subdivision The number of ticks per beat that should apply from the following step.
+    /// @note  A change in subdivision rescales the position within the beat, so the phase of the beat is preserved.
+
+    inline void advance(uint64_t subdivision) noexcept
+    {
+        position = position + 1;
+
+        if (subdivision != this->subdivision && subdivision > 0)
+        {
+            const uint64_t steps = std::lcm(PULSES_PER_BEAT, subdivision);
+
+            position = position * steps / resolution;
+            resolution = steps;
+            this->subdivision = subdivision;
+        }
+
+        position = position % resolution;
+    }
+
+    /// @brief Restart the grid so that its next step is the first step of a beat.
+
+    inline void reset() noexcept
+    {
+        position = 0;
+    }
+};
+
+#endif
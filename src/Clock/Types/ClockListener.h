@@ -4,6 +4,8 @@
 #ifndef CLOCKLISTENER_H
 #define CLOCKLISTENER_H
 
+#include "ClockTick.h"
+
 /// @brief A class to be subclassed by classes that should be notified when a clock ticks.
 
 class ClockListener
@@ -11,8 +13,15 @@ class ClockListener
 public:
 
     /// @brief The callback that's executed when a clock ticks.
+    /// @param tick A description of the moment at which the tick should be realised.
+
+    virtual void tick(const ClockTick& tick) = 0;
+
+    /// @brief The callback that's executed on each 24-PPQN MIDI clock pulse of an internal clock.
+    /// @param pulse A description of the moment at which the pulse should be realised.
+    /// @note  Pulses are broadcast before the tick that falls on the same step, if any.
 
-    virtual void tick() = 0;
+    virtual void pulse(const ClockTick& pulse) {}
 };
 
 #endif
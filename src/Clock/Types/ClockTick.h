@@ -0,0 +1,36 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef CLOCKTICK_H
+#define CLOCKTICK_H
+
+#include <chrono>
+#include <cstdint>
+
+/// @brief A description of the moment at which a clock tick should be realised.
+
+struct ClockTick
+{
+    /// @brief The offset of the tick in frames from the start of the buffer in which it occurred.
+    /// @note  This is zero for clock engines that don't process buffers.
+
+    uint32_t offset = 0;
+    
+    /// @brief The host time in microseconds at which the tick should be realised.
+
+    uint64_t timestamp = 0;
+
+    /// @brief Return the current host time in microseconds.
+    /// @note  The host time is monotonic and is shared by all clock engines and the MIDI server.
+
+    inline static uint64_t now() noexcept
+    {
+        using namespace std::chrono;
+
+        const auto time = steady_clock::now().time_since_epoch();
+
+        return static_cast<uint64_t>(duration_cast<microseconds>(time).count());
+    }
+};
+
+#endif
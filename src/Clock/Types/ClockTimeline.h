@@ -0,0 +1,74 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef CLOCKTIMELINE_H
+#define CLOCKTIMELINE_H
+
+#include <cstdint>
+
+/// @brief A timeline of ticks whose period is the rational number `numerator / denominator` in some unit of time, e.g., frames.
+/// @note  Tick N is placed at `origin + round(N * numerator / denominator)`, so the rounding error of each tick never accumulates.
+///        The period can be changed at any tick boundary without disturbing the phase of the tick that has just been realised.
+
+struct ClockTimeline
+{
+    /// @brief The time of the timeline's first tick.
+
+    uint64_t origin = 0;
+
+    /// @brief The index of the next tick relative to the timeline's origin.
+
+    uint64_t index = 0;
+
+    /// @brief The numerator of the timeline's period.
+
+    uint64_t numerator = 1;
+
+    /// @brief The denominator of the timeline's period.
+
+    uint64_t denominator = 1;
+
+    /// @brief Return the time of the next tick.
+
+    inline uint64_t next() const noexcept
+    {
+        return origin + (2 * index * numerator + denominator) / (2 * denominator);
+    }
+
+    /// @brief Advance to the following tick after the next tick has been realised.
+    /// @param numerator The numerator of the period that should separate the realised tick from the following tick.
+    /// @param denominator The denominator of the period that should separate the realised tick from the following tick.
+
+    inline void advance(uint64_t numerator, uint64_t denominator) noexcept
+    {
+        if (numerator != this->numerator || denominator != this->denominator)
+        {
+            origin = next();
+            index  = 0;
+            this->numerator   = numerator;
+            this->denominator = denominator;
+        }
+
+        index = index + 1;
+
+        // Every `denominator` ticks, the time of the next tick is an integer, so the origin can be moved there exactly.
+        // This keeps `index` small enough that computing the time of a tick can never overflow.
+
+        if (index == this->denominator)
+        {
+            origin = origin + this->numerator;
+            index  = 0;
+        }
+    }
+
+    /// @brief Restart the timeline so that its next tick is realised at the given time.
+    /// @param time The time of the next tick.
+
+    inline void reset(uint64_t time) noexcept
+    {
+        origin = time;
+        index  = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,158 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef DELAYLOCKEDLOOP_H
+#define DELAYLOCKEDLOOP_H
+
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+/// @brief A second-order delay-locked loop that estimates the period and phase of a jittery periodic event, such as a MIDI clock pulse.
+/// @note  Each event's arrival time is compared to the time that was predicted for it and the error is used to correct both the
+///        predicted time of the next event and the estimated period. The loop's bandwidth determines how quickly it follows changes
+///        in tempo and how strongly it suppresses the jitter of each arrival time.
+
+class DelayLockedLoop
+{
+public:
+    DelayLockedLoop()
+    {
+        setBandwidth(1.0 / 96.0);
+    }
+
+public:
+    /// @brief Set the bandwidth of the loop as a fraction of the event rate.
+    /// @param bandwidth The desired bandwidth in cycles per event, where smaller values suppress more jitter but follow changes more slowly.
+
+    inline void setBandwidth(double bandwidth) noexcept
+    {
+        const double omega = 2.0 * M_PI * std::max(bandwidth, 1e-6);
+
+        b = std::sqrt(2.0) * omega;
+        c = omega * omega;
+    }
+
+    /// @brief Update the loop with the arrival time of a new event.
+    /// @param time The time at which the event arrived.
+    /// @return The filtered estimate of the time at which the event occurred.
+
+    inline double update(double time) noexcept
+    {
+        switch (events)
+        {
+            case 0:
+            {
+                events = 1;
+                current = time;
+                return current;
+            }
+
+            case 1:
+            {
+                events = 2;
+                initialise(time, time - current);
+                return current;
+            }
+
+            default: break;
+        }
+
+        const double error = time - predicted;
+        const double limit = period * 0.5;
+
+        // Large errors are usually caused by a stalled sender, a dropped message, or a sudden change in tempo.
+        // A single large error is clamped so that it doesn't disturb the loop, but a sequence of them causes the loop to relock.
+
+        if (std::abs(error) > limit)
+        {
+            outliers = outliers + 1;
+
+            if (outliers >= MAXIMUM_OUTLIERS)
+            {
+                initialise(time, time - previous);
+                previous = time;
+                return current;
+            }
+        }
+
+        else outliers = 0;
+
+        const double e = std::max(-limit, std::min(limit, error));
+
+        previous  = time;
+        current   = predicted;
+        predicted = predicted + b * e + period;
+        period    = period + c * e;
+
+        return current;
+    }
+
+    /// @brief Forget the state of the loop.
+
+    inline void reset() noexcept
+    {
+        events = 0;
+        outliers = 0;
+    }
+
+public:
+    /// @brief Indicate whether the loop has received enough events to estimate the period.
+
+    inline bool isLocked() const noexcept
+    {
+        return events >= 2;
+    }
+
+    /// @brief Return the estimated period between events.
+
+    inline double getPeriod() const noexcept
+    {
+        return period;
+    }
+
+    /// @brief Return the predicted time of the next event.
+
+    inline double getPredictedTime() const noexcept
+    {
+        return predicted;
+    }
+
+    /// @brief Return the filtered estimate of the time at which the most recent event occurred.
+
+    inline double getCurrentTime() const noexcept
+    {
+        return current;
+    }
+
+private:
+    /// @brief Lock the loop onto the given event time and period.
+
+    inline void initialise(double time, double period) noexcept
+    {
+        this->period = std::max(period, 1.0);
+        this->current = time;
+        this->previous = time;
+        this->predicted = time + this->period;
+        this->outliers = 0;
+    }
+
+private:
+    double b = 0.0;
+    double c = 0.0;
+
+private:
+    double period = 1.0;
+    double current = 0.0;
+    double previous = 0.0;
+    double predicted = 0.0;
+
+private:
+    uint64_t events = 0;
+    uint32_t outliers = 0;
+
+private:
+    constexpr static uint32_t MAXIMUM_OUTLIERS = 3;
+};
+
+#endif
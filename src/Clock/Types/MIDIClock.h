@@ -5,10 +5,12 @@
 #define MIDICLOCK_H
 
 #include "ClockEngine.h"
-#include "ofxMidiClock.h"
+#include "DelayLockedLoop.h"
 #include "ofxMidi.h"
 
 /// @brief A clock engine that receives ticks from an external MIDI clock source.
+/// @note  The arrival time of each clock pulse is filtered by a delay-locked loop, which estimates the tempo and predicts the
+///        time of the next pulse. Ticks are spaced evenly between pulses, so the subdivision needn't divide the pulse rate.
 
 class MIDIClock: public ClockEngine, public ofxMidiListener
 {
@@ -34,16 +36,26 @@ private:
     }
     
 public:
-    /// @brief Set the frame rate of the MIDI clock in frames per second.
+    /// @brief Set the frame rate of the MIDI clock, which is the number of clock pulses per beat.
     /// @param framesPerSecond The frame rate of the MIDI clock.
 
     inline void setFrameRate(unsigned int framesPerSecond) noexcept
     {
-        if (frameRate == framesPerSecond)
-            return;
-        
-        frameRate = std::max(static_cast<int>(framesPerSecond), 1);
-        updateParameters();
+        frameRate = std::max(framesPerSecond, 1u);
+    }
+    
+    /// @brief Return the estimated period between clock pulses in microseconds.
+
+    inline double getPulsePeriod() const noexcept
+    {
+        return loop.getPeriod();
+    }
+    
+    /// @brief Return the predicted host time in microseconds of the next clock pulse.
+
+    inline double getPredictedPulseTime() const noexcept
+    {
+        return loop.getPredictedTime();
     }
     
     /// @brief Close the current MIDI port and open the given MIDI port.
@@ -105,31 +117,48 @@ public:
     
 private:
 
-    /// @brief Adance the clock forwards and broadcast ticks to listeners when appropriate.
+    /// @brief Broadcast each tick that falls between the current clock pulse and the next clock pulse.
+    /// @param time The filtered host time in microseconds of the current clock pulse.
+    /// @note  Tick `k` lies `k * frameRate / subdivision` pulses from the most recent reset. Ticks that fall between pulses
+    ///        are stamped with a time interpolated towards the predicted time of the next pulse.
 
-    inline void advance()
+    inline void advance(double time)
     {
-        time = time + 1;
-        time = time * static_cast<int>(time < tickLength);
-        
-        if (time == 0)
-            tick();
+        const uint64_t n = pulse;
+        const uint64_t s = subdivision;
+        const uint64_t p = frameRate;
+        const double period = loop.isLocked() ? loop.getPeriod() : 0.0;
+
+        for (uint64_t k = (n * s + p - 1) / p; k * p < (n + 1) * s; ++k)
+        {
+            const double fraction = static_cast<double>(k * p - n * s) / static_cast<double>(s);
+            const double timestamp = time + fraction * period;
+
+            tick({0, static_cast<uint64_t>(std::max(timestamp, 0.0))});
+        }
+
+        pulse = pulse + 1;
     }
     
-    /// @brief Reset the time keeping value to zero.
+    /// @brief Reset the pulse count to zero.
 
     inline void reset()
     {
-        time = 0;
+        pulse = 0;
     }
     
-    /// @brief Update the inferred tempo value from the MIDI clock.
+    /// @brief Update the inferred tempo value from the estimated period between clock pulses.
 
     inline void updateInferredTempo()
     {
-        inferredTempo = inferredTempo + (midiClock.getBpm() - inferredTempo) / 5.0;
+        if (!loop.isLocked())
+            return;
+
+        const double beat = loop.getPeriod() * static_cast<double>(frameRate);
+
+        inferredTempo = 60000000.0 / beat;
         
-        tempo = static_cast<unsigned int>(inferredTempo);
+        tempo = static_cast<unsigned int>(std::round(inferredTempo));
     }
     
     /// @brief The callback executed when new MIDI messages are received.
@@ -137,22 +166,22 @@ private:
 
     inline void newMidiMessage(ofxMidiMessage& message) override
     {
-        auto & bytes = message.bytes;
-        auto & state = message.status;
-
-        midiClock.update(bytes);
-        updateInferredTempo();
+        const double now = static_cast<double>(ClockTick::now());
 
-        if (!ticking) return;
-        
-        switch (state)
+        switch (message.status)
         {
             case MIDI_TIME_CLOCK:
             {
-                advance();
+                const double time = loop.update(now);
+                updateInferredTempo();
+
+                if (ticking)
+                    advance(time);
+
                 return;
             }
             
+            case MIDI_START:
             case MIDI_STOP:
             {
                 reset();
@@ -163,21 +192,15 @@ private:
         }
     }
 
-    /// @brief Update the tick length based on the frame rate and the subdivision.
-
-    inline void updateParameters()
-    {
-        tickLength = frameRate / subdivision;
-    }
-
 private:
-    ofxMidiIn    midiIn;
-    ofxMidiClock midiClock;
+    ofxMidiIn midiIn;
+    DelayLockedLoop loop;
     
 private:
-    unsigned int time;
-    unsigned int tickLength;
-    unsigned int frameRate;
+    /// @brief The number of clock pulses received since the clock was reset.
+
+    uint64_t pulse = 0;
+    unsigned int frameRate = 24;
     
 private:
     double inferredTempo = 100.0;
@@ -5,8 +5,11 @@
 #define SAMPLECLOCK_H
 
 #include "ClockEngine.h"
+#include "ClockTimeline.h"
 
 /// @brief An internal clock engine that uses the sample rate of the sound output device to measure time.
+/// @note  Time is measured as an absolute 64-bit frame position and each tick's position is derived from
+///        the exact rational step length of the beat grid, so the clock doesn't drift against other devices.
 
 class SampleClock: public ClockEngine, public ofBaseSoundOutput
 {
@@ -44,6 +47,13 @@ public:
         toggleClock();
     }
 
+    /// @brief Indicate whether a sound output device was available to drive the clock or not.
+
+    inline bool hasOutputDevice() const noexcept
+    {
+        return outputDeviceIsAvailable;
+    }
+
     /// @brief Set the clock's sample rate in samples per second.
     /// @param samplesPerSecond The desired sample rate.
 
@@ -54,21 +64,6 @@ public:
         
         initialiseSoundStream(samplesPerSecond);
         sampleRate = samplesPerSecond;
-        updateParameters();
-    }
-    
-    inline void setTempo(unsigned int beatsPerMinute) noexcept override
-    {
-        ClockEngine::setTempo(beatsPerMinute);
-        
-        updateParameters();
-    }
-
-    inline void setSubdivision(unsigned int ticksPerBeat) noexcept override
-    {
-        ClockEngine::setSubdivision(ticksPerBeat);
-        
-        updateParameters();
     }
 
     /// @brief The audio callback where sound buffers are processed at the sample rate.
@@ -76,43 +71,72 @@ public:
 
     inline void audioOut(ofSoundBuffer& buffer) override
     {
-        for (size_t k = 0; k < buffer.getNumFrames(); ++k)
-        {
-            advance();
-        }
+        const uint32_t frames = static_cast<uint32_t>(buffer.getNumFrames());
+        const uint64_t origin = computeBufferTimestamp(frames);
+
+        advance(frames, origin);
     }
     
 private:
-    /// @brief Adance the clock forwards and broadcast ticks to listeners when appropriate.
+    /// @brief Advance the clock by the given number of frames and broadcast each tick and pulse that falls within them.
+    /// @param frames The number of frames in the current buffer.
+    /// @param origin The host time in microseconds at which the buffer's first frame should be realised.
     
-    inline void advance() noexcept
+    inline void advance(uint32_t frames, uint64_t origin) noexcept
     {
-        time = time + 1;
-        time = time * static_cast<int>(time < tickLength);
+        const uint64_t end = position + frames;
+        const uint64_t samplesPerMinute = static_cast<uint64_t>(sampleRate) * 60;
+
+        while (timeline.next() < end)
+        {
+            const uint32_t offset = static_cast<uint32_t>(timeline.next() - position);
 
-        if (time == 0)
-            tick();
+            step({offset, origin + framesToMicroseconds(offset)});
+
+            timeline.advance(samplesPerMinute, getStepsPerMinute());
+        }
+
+        position = end;
     }
     
-    /// @brief Reset the time keeping value to zero.
-
-    inline void reset() noexcept
+    /// @brief Compute the host time at which the first frame of the current buffer should be realised.
+    /// @param frames The number of frames in the current buffer.
+    /// @note  Buffer timestamps advance by the duration of each buffer rather than following the time at which
+    ///        each callback happens to run, so the jitter of the audio callback is not passed on to the listeners.
+    ///        Every timestamp is delayed by the duration of one buffer so that each tick's timestamp is in the future.
+    ///        The timeline is realigned with the host time if the two drift apart by more than one buffer.
+
+    inline uint64_t computeBufferTimestamp(uint32_t frames) noexcept
     {
-        time = 0;
-    }
+        const uint64_t latency  = framesToMicroseconds(frames);
+        const uint64_t target   = ClockTick::now() + latency;
+        const uint64_t expected = bufferTimestamp + framesToMicroseconds(bufferFrames);
+        const uint64_t drift    = expected > target ? expected - target : target - expected;
 
-private:
-    /// @brief Update the tick length based on the clock's tempo, sample rate, and time subdivision.
+        bufferFrames    = frames;
+        bufferTimestamp = drift > latency ? target : expected;
 
-    inline void updateParameters() noexcept
-    {
-        const float sixty = static_cast<float>(sampleRate * 60);
-        const float ticks = static_cast<float>(tempo)
-                          * static_cast<float>(subdivision);
+        return bufferTimestamp;
+    }
+    
+    /// @brief Convert the given number of frames to a duration in microseconds at the clock's sample rate.
+    /// @param frames The number of frames to convert.
 
-        tickLength = static_cast<int>(sixty / ticks);
+    inline uint64_t framesToMicroseconds(uint64_t frames) const noexcept
+    {
+        return frames * 1000000 / std::max(sampleRate, 1u);
     }
     
+    /// @brief Reset the frame position to zero so that the next beat is realised by the next frame.
+
+    inline void reset() noexcept
+    {
+        position = 0;
+        timeline.reset(0);
+        grid.reset();
+    }
+
+private:
     /// @brief Initialise the sound output settings and begin processing buffers at the sample rate.
     /// @param sampleRate The sample rate to use.
     /// @note  This is called whenever the sample rate is updated using `setSampleRate`.
@@ -121,6 +145,8 @@ private:
     {
         ofSoundDevice * const device = getDefaultOutputDevice();
 
+        outputDeviceIsAvailable = device != nullptr;
+
         if (device == nullptr)
             return;
         
@@ -154,11 +180,28 @@ private:
     
 private:
     ofSoundStream soundstream;
+    bool outputDeviceIsAvailable = false;
     
 private:
-    unsigned int time;
-    unsigned int tickLength;
-    unsigned int sampleRate;
+    unsigned int sampleRate = 0;
+    
+    /// @brief The number of frames that have been processed since the clock was reset.
+
+    uint64_t position = 0;
+    
+    /// @brief The frame positions of the steps of the clock's beat grid.
+    /// @note  The step length in frames is the rational number `sampleRate * 60 / (tempo * lcm(24, subdivision))`.
+
+    ClockTimeline timeline;
+    
+private:
+    /// @brief The host time at which the first frame of the most recent buffer should be realised.
+
+    uint64_t bufferTimestamp = 0;
+    
+    /// @brief The number of frames in the most recent buffer.
+
+    uint32_t bufferFrames = 0;
 };
 
 #endif
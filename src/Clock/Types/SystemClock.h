@@ -0,0 +1,172 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef SYSTEMCLOCK_H
+#define SYSTEMCLOCK_H
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <pthread.h>
+#include "ClockEngine.h"
+#include "ClockTimeline.h"
+
+/// @brief An internal clock engine that measures time with the host's monotonic clock, which requires no sound device.
+/// @note  Ticks are realised by a dedicated timer thread, which sleeps until the absolute deadline of each tick
+///        rather than for the duration of each tick, so the time spent processing each tick doesn't accumulate as drift.
+
+class SystemClock: public ClockEngine
+{
+public:
+    ~SystemClock()
+    {
+        stop();
+    }
+
+public:
+    inline void toggleClock() noexcept override
+    {
+        ClockEngine::toggleClock();
+
+        if (ticking)
+             start();
+        else stop();
+    }
+
+    inline void setClockShouldTick(bool shouldTick) noexcept override
+    {
+        if (ticking == shouldTick) {
+            return;
+        }
+
+        toggleClock();
+    }
+
+    /// @brief Request that the timer thread be scheduled with the first-in-first-out real-time policy.
+    /// @param shouldUseRealtimePriority Whether the timer thread should use a real-time scheduling policy or not.
+    /// @note  This requires the appropriate privileges. The thread uses the default policy if the request is denied.
+
+    inline void setUsesRealtimePriority(bool shouldUseRealtimePriority) noexcept
+    {
+        usesRealtimePriority = shouldUseRealtimePriority;
+
+        if (timer.joinable() && usesRealtimePriority)
+            promote(timer.native_handle());
+    }
+
+private:
+    /// @brief Start the timer thread.
+
+    inline void start() noexcept
+    {
+        if (timer.joinable())
+            return;
+
+        running.store(true);
+        timer = std::thread(&SystemClock::run, this);
+
+        if (usesRealtimePriority)
+            promote(timer.native_handle());
+    }
+
+    /// @brief Stop the timer thread and wait for it to finish.
+
+    inline void stop() noexcept
+    {
+        running.store(false);
+
+        if (timer.joinable())
+            timer.join();
+    }
+
+    /// @brief Broadcast ticks and pulses at their deadlines until the clock is stopped.
+    /// @note  This is the body of the timer thread. Steps of the beat grid on which nothing falls are passed over without waiting.
+
+    inline void run() noexcept
+    {
+        ClockTimeline timeline;
+        timeline.reset(now());
+
+        while (running.load())
+        {
+            const uint64_t deadline = timeline.next();
+
+            if (stepHasEvents())
+            {
+                wait(deadline);
+
+                if (!running.load())
+                    break;
+            }
+
+            step({0, deadline / 1000 + LATENCY});
+
+            // Changes in tempo take effect at the next step boundary without disturbing the phase of the current step.
+
+            timeline.advance(NANOSECONDS_PER_MINUTE, getStepsPerMinute());
+        }
+    }
+
+    /// @brief Block the timer thread until the given deadline.
+    /// @param deadline The host time in nanoseconds at which the thread should resume.
+    /// @note  The thread sleeps until shortly before the deadline and then yields until the deadline arrives,
+    ///        which keeps the thread's wake-up jitter well under the resolution of the operating system's scheduler.
+
+    inline void wait(uint64_t deadline) noexcept
+    {
+        using namespace std::chrono;
+
+        if (deadline > SPIN_INTERVAL)
+        {
+            const steady_clock::time_point wake {nanoseconds(deadline - SPIN_INTERVAL)};
+            std::this_thread::sleep_until(wake);
+        }
+
+        while (now() < deadline && running.load())
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    /// @brief Return the host time in nanoseconds.
+
+    inline static uint64_t now() noexcept
+    {
+        using namespace std::chrono;
+
+        const auto time = steady_clock::now().time_since_epoch();
+
+        return static_cast<uint64_t>(duration_cast<nanoseconds>(time).count());
+    }
+
+    /// @brief Schedule the given thread with the first-in-first-out real-time policy.
+    /// @param thread The thread to be promoted.
+
+    inline static void promote(pthread_t thread) noexcept
+    {
+        sched_param parameters;
+        parameters.sched_priority = sched_get_priority_max(SCHED_FIFO);
+
+        if (pthread_setschedparam(thread, SCHED_FIFO, &parameters) != 0)
+            ofLogWarning("SystemClock", "The timer thread could not be given a real-time priority.");
+    }
+
+private:
+    std::thread timer;
+    std::atomic<bool> running = {false};
+    bool usesRealtimePriority = false;
+
+private:
+    constexpr static uint64_t NANOSECONDS_PER_MINUTE = 60000000000;
+
+    /// @brief The duration in nanoseconds before each deadline for which the timer thread yields rather than sleeps.
+
+    constexpr static uint64_t SPIN_INTERVAL = 300000;
+
+    /// @brief The delay in microseconds between the moment each step is broadcast and the moment it should be realised.
+    /// @note  This gives listeners time to process each tick before its messages are due.
+
+    constexpr static uint64_t LATENCY = 1000;
+};
+
+#endif
@@ -0,0 +1,180 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef ENGINENODE_H
+#define ENGINENODE_H
+
+#include <cstdint>
+#include "UIPoint.h"
+
+/// @brief Constants defining nodes that can be placed on the Ensemble sequencer.
+
+enum  SQNodeType : uint8_t { Redirect, Playhead, Portal, Note, Subsequence };
+
+/// @brief Constants defining the different types of redirection nodes.
+
+enum  Redirection : uint8_t { X, Y, Diagonal, Alternating, Random };
+
+/// @brief Constants defining the two different types of portals.
+
+enum  PortalType : uint8_t { A, B };
+
+/// @brief The state of a redirect node.
+
+struct RedirectState
+{
+    /// @brief The redirect's type.
+
+    Redirection redirection;
+
+    /// @brief The alternating state of an Alternating redirect.
+
+    bool state;
+
+    /// @brief The current redirection type of a Random redirect.
+
+    uint8_t choice;
+
+    /// @brief The number of choices a Random redirect has made, from which its next choice is derived.
+    /// @note  The counter wraps after 65,536 choices, after which the redirect repeats its choices from the start.
+
+    uint16_t counter;
+};
+
+/// @brief The state of a portal node.
+
+struct PortalState
+{
+    /// @brief The portal's type.
+
+    PortalType type;
+
+    /// @brief Whether the portal is paired or not.
+
+    bool paired;
+
+    /// @brief The column index of the portal's pair.
+
+    uint16_t x;
+
+    /// @brief The row index of the portal's pair.
+
+    uint16_t y;
+};
+
+/// @brief The state of a subsequence node.
+
+struct SubsequenceState
+{
+    /// @brief The index of the subsequence's notes in the engine's pool of subsequences.
+
+    uint16_t index;
+};
+
+/// @brief The state of a node on the sequencer's grid, which is a plain record that can be copied freely between threads.
+/// @note  A node is a tagged union of the states of each type of node, so the grid stores nodes by value in eight bytes each
+///        and the sequencer engine dispatches on the node's type with a switch. The node's position is implied by the cell
+///        in which it's stored. Only the member of the union that matches the node's type is meaningful.
+
+struct EngineNode
+{
+    EngineNode():
+    type(Redirect), redirect{Redirection::X, false, 0, 0}
+    {
+
+    }
+
+    /// @brief Construct a redirect node.
+    /// @param redirection The redirect's type.
+
+    inline static EngineNode makeRedirect(Redirection redirection) noexcept
+    {
+        EngineNode node;
+        node.type = Redirect;
+        node.redirect = {redirection, false, 0, 0};
+        return node;
+    }
+
+    /// @brief Construct an unpaired portal node.
+    /// @param type The portal's type.
+
+    inline static EngineNode makePortal(PortalType type) noexcept
+    {
+        EngineNode node;
+        node.type = Portal;
+        node.portal = {type, false, 0, 0};
+        return node;
+    }
+
+    /// @brief Construct a subsequence node.
+    /// @param index The index of the subsequence's notes in the engine's pool of subsequences.
+
+    inline static EngineNode makeSubsequence(uint16_t index) noexcept
+    {
+        EngineNode node;
+        node.type = Subsequence;
+        node.subsequence = {index};
+        return node;
+    }
+
+public:
+    /// @brief The node's type, which determines the meaningful member of the union.
+
+    SQNodeType type;
+
+    union
+    {
+        RedirectState    redirect;
+        PortalState      portal;
+        SubsequenceState subsequence;
+    };
+
+public:
+    /// @brief Determine whether a redirect currently behaves as an X, Y, or Diagonal redirect.
+
+    inline Redirection readBasicRedirectionType() const noexcept
+    {
+        switch (redirect.redirection)
+        {
+            case Redirection::Alternating: return static_cast<Redirection>(static_cast<int>(redirect.state));
+            case Redirection::Random:      return static_cast<Redirection>(static_cast<int>(redirect.choice));
+            default: return redirect.redirection;
+        }
+    }
+
+    /// @brief Indicate whether the redirect's behaviour changes each time it redirects a playhead, i.e., whether it's an Alternating
+    ///        or Random redirect.
+
+    inline bool isStateful() const noexcept
+    {
+        return redirect.redirection == Redirection::Alternating || redirect.redirection == Redirection::Random;
+    }
+
+    /// @brief Get the portal's opposite portal type.
+
+    inline PortalType getPairPortalType() const noexcept
+    {
+        return portal.type == PortalType::A ? PortalType::B : PortalType::A;
+    }
+
+    /// @brief Get the position of the portal's pair as column and row indices.
+
+    inline UIPoint<int> getPairPosition() const noexcept
+    {
+        return {portal.x, portal.y};
+    }
+
+    /// @brief Pair the portal with the portal at the given position.
+    /// @param xy The position of the portal's pair as column and row indices.
+
+    inline void setPairPosition(const UIPoint<int>& xy) noexcept
+    {
+        portal.paired = true;
+        portal.x = static_cast<uint16_t>(xy.x);
+        portal.y = static_cast<uint16_t>(xy.y);
+    }
+};
+
+static_assert(sizeof(EngineNode) == 8, "Nodes should be packed into eight bytes.");
+
+#endif
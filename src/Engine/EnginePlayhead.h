@@ -0,0 +1,122 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef ENGINEPLAYHEAD_H
+#define ENGINEPLAYHEAD_H
+
+#include <cstdint>
+#include <algorithm>
+#include "UIPoint.h"
+#include "UISize.h"
+
+/// @brief The state of a playhead that moves on the sequencer and broadcasts information.
+/// @note  Each playhead moves at its own rate, which is a multiple and a division of the clock's tick rate, e.g., 5/4 or 1/3.
+///        The time of each move is measured in fractions of a tick since the playhead's origin, so the moves of a playhead
+///        whose rate isn't a whole number are spread evenly within and across ticks without accumulating error.
+
+struct EnginePlayhead
+{
+    /// @brief The playhead's position as column and row indices.
+
+    UIPoint<int> xy;
+
+    /// @brief The playhead's direction.
+
+    UIPoint<int> delta = {0, 1};
+
+    /// @brief The number of moves the playhead has made since its origin.
+
+    uint64_t moves = 0;
+
+    /// @brief The absolute tick of the playhead's first move at its current rate.
+
+    uint64_t origin = 0;
+
+    uint8_t multiplier = 1;
+    uint8_t divider    = 1;
+
+    /// @brief Whether the playhead broadcasts the notes it lands on or not.
+
+    bool enabled = true;
+
+    /// @brief Whether the playhead is selected by the user or not.
+
+    bool selected = false;
+
+public:
+    /// @brief Move the playhead by its direction, wrapping around the edges of the grid.
+    /// @param gridSize The dimensions of the grid in rows and columns.
+
+    inline void update(const UISize<int>& gridSize) noexcept
+    {
+        xy.x = (xy.x + delta.x + gridSize.w) % gridSize.w;
+        xy.y = (xy.y + delta.y + gridSize.h) % gridSize.h;
+    }
+
+    /// @brief Set the rate at which the playhead moves relative to the clock's tick rate.
+    /// @param multiplier The number of moves per `divider` ticks in the range [1, 8].
+    /// @param divider The number of ticks per `multiplier` moves in the range [1, 8].
+    /// @param tick The absolute tick from which the playhead should move at the new rate.
+
+    inline void setRate(unsigned int multiplier, unsigned int divider, uint64_t tick) noexcept
+    {
+        this->multiplier = static_cast<uint8_t>(std::min(std::max(multiplier, 1u), MAXIMUM_RATE));
+        this->divider    = static_cast<uint8_t>(std::min(std::max(divider,    1u), MAXIMUM_RATE));
+
+        setOrigin(tick);
+    }
+
+    /// @brief Restart the playhead's timing so that its next move falls at the start of the given tick.
+    /// @param tick The absolute tick of the playhead's next move.
+
+    inline void setOrigin(uint64_t tick) noexcept
+    {
+        origin = tick;
+        moves  = 0;
+    }
+
+    /// @brief Compute the time of the playhead's next move in units of `1 / TICK_RESOLUTION` ticks.
+
+    inline uint64_t getNextMoveTime() const noexcept
+    {
+        return getMoveTime(moves);
+    }
+
+    /// @brief Compute the time of the given move since the playhead's origin in units of `1 / TICK_RESOLUTION` ticks.
+    /// @param move The index of the move, where the first move after the origin has index zero.
+
+    inline uint64_t getMoveTime(uint64_t move) const noexcept
+    {
+        return origin * TICK_RESOLUTION + move * getMoveInterval();
+    }
+
+    /// @brief Compute the time between successive moves in units of `1 / TICK_RESOLUTION` ticks.
+
+    inline uint64_t getMoveInterval() const noexcept
+    {
+        return TICK_RESOLUTION * divider / multiplier;
+    }
+
+    /// @brief Compute the number of moves the playhead makes after its origin and before the start of the given tick.
+    /// @param tick An absolute tick.
+
+    inline uint64_t getNumberOfMovesBefore(uint64_t tick) const noexcept
+    {
+        if (tick <= origin) return 0;
+
+        const uint64_t interval = getMoveInterval();
+
+        return ((tick - origin) * TICK_RESOLUTION + interval - 1) / interval;
+    }
+
+public:
+    /// @brief The greatest multiplier or divider of a playhead's rate.
+
+    constexpr static unsigned int MAXIMUM_RATE = 8;
+
+    /// @brief The number of units per tick in which move times are measured, which is divisible by every possible multiplier.
+
+    constexpr static uint64_t TICK_RESOLUTION = 840;
+};
+
+#endif
@@ -0,0 +1,366 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef ENGINEPLAYHEADS_H
+#define ENGINEPLAYHEADS_H
+
+#include <limits>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include "UISize.h"
+#include "EnginePlayhead.h"
+
+/// @brief The sequencer engine's playheads, stored as a structure of arrays so that the playheads that are due can be advanced in bulk.
+/// @note  Each field of every playhead is stored contiguously, and the moves of the playheads are branchless.
+///        Playheads whose next moves are due at the same time and whose moves are equally spaced move in lockstep, so they're
+///        scheduled together as a group in a min-heap ordered by the time of each group's next move. Only the playheads that are due
+///        are visited, regardless of the number of playheads, and playheads that are due at the same time move in the order in which
+///        they were placed. Playheads move one cell at a time, so each component of a playhead's direction is -1, 0, or +1.
+
+class EnginePlayheads
+{
+public:
+    /// @brief A group of playheads that move in lockstep, whose indices are `members[begin, end)` in ascending order.
+
+    struct Group
+    {
+        uint64_t time;
+        uint32_t interval;
+        uint32_t begin;
+        uint32_t end;
+
+        inline bool operator > (const Group& other) const noexcept
+        {
+            return time > other.time;
+        }
+    };
+
+public:
+    /// @brief Reserve storage for the given number of playheads.
+    /// @param capacity The greatest number of playheads.
+
+    inline void reserve(size_t capacity) noexcept(false)
+    {
+        x.reserve(capacity);
+        y.reserve(capacity);
+        dx.reserve(capacity);
+        dy.reserve(capacity);
+        moves.reserve(capacity);
+        origin.reserve(capacity);
+        next.reserve(capacity);
+        interval.reserve(capacity);
+        multiplier.reserve(capacity);
+        divider.reserve(capacity);
+        enabled.reserve(capacity);
+        selected.reserve(capacity);
+        members.reserve(capacity);
+        groups.reserve(capacity);
+        due.resize((capacity + 63) / 64);
+    }
+
+    /// @brief Return the number of playheads.
+
+    inline size_t size() const noexcept
+    {
+        return x.size();
+    }
+
+    /// @brief Indicate whether there's no room for another playhead.
+
+    inline bool isFull() const noexcept
+    {
+        return x.size() == x.capacity();
+    }
+
+// MARK: - Records
+
+public:
+    /// @brief Add a playhead.
+    /// @param playhead The state of the playhead to be added.
+    /// @note  There must be room for the playhead. The playhead doesn't move until the playheads are scheduled.
+
+    inline void push(const EnginePlayhead& playhead) noexcept
+    {
+        x.push_back(playhead.xy.x);
+        y.push_back(playhead.xy.y);
+        dx.push_back(playhead.delta.x);
+        dy.push_back(playhead.delta.y);
+        moves.push_back(playhead.moves);
+        origin.push_back(playhead.origin);
+        next.push_back(playhead.getNextMoveTime());
+        interval.push_back(static_cast<uint32_t>(playhead.getMoveInterval()));
+        multiplier.push_back(playhead.multiplier);
+        divider.push_back(playhead.divider);
+        enabled.push_back(playhead.enabled);
+        selected.push_back(playhead.selected);
+    }
+
+    /// @brief Remove the playhead at the given index, preserving the order of the others.
+    /// @param index The index of the playhead, which must be in range.
+    /// @note  No playhead moves until the playheads are scheduled again.
+
+    inline void erase(size_t index) noexcept
+    {
+        x.erase(x.begin() + index);
+        y.erase(y.begin() + index);
+        dx.erase(dx.begin() + index);
+        dy.erase(dy.begin() + index);
+        moves.erase(moves.begin() + index);
+        origin.erase(origin.begin() + index);
+        next.erase(next.begin() + index);
+        interval.erase(interval.begin() + index);
+        multiplier.erase(multiplier.begin() + index);
+        divider.erase(divider.begin() + index);
+        enabled.erase(enabled.begin() + index);
+        selected.erase(selected.begin() + index);
+        groups.clear();
+    }
+
+    /// @brief Remove every playhead without releasing any storage.
+
+    inline void clear() noexcept
+    {
+        x.clear();
+        y.clear();
+        dx.clear();
+        dy.clear();
+        moves.clear();
+        origin.clear();
+        next.clear();
+        interval.clear();
+        multiplier.clear();
+        divider.clear();
+        enabled.clear();
+        selected.clear();
+        members.clear();
+        groups.clear();
+    }
+
+    /// @brief Return the state of the playhead at the given index.
+    /// @param index The index of the playhead, which must be in range.
+
+    inline EnginePlayhead get(size_t index) const noexcept
+    {
+        EnginePlayhead playhead;
+        playhead.xy.set(x[index], y[index]);
+        playhead.delta.set(dx[index], dy[index]);
+        playhead.moves      = moves[index];
+        playhead.origin     = origin[index];
+        playhead.multiplier = multiplier[index];
+        playhead.divider    = divider[index];
+        playhead.enabled    = enabled[index];
+        playhead.selected   = selected[index];
+
+        return playhead;
+    }
+
+    /// @brief Replace the state of the playhead at the given index.
+    /// @param index The index of the playhead, which must be in range.
+    /// @param playhead The playhead's new state.
+    /// @note  The playhead's new timing takes effect when the playheads are scheduled again.
+
+    inline void set(size_t index, const EnginePlayhead& playhead) noexcept
+    {
+        x[index]          = playhead.xy.x;
+        y[index]          = playhead.xy.y;
+        dx[index]         = playhead.delta.x;
+        dy[index]         = playhead.delta.y;
+        moves[index]      = playhead.moves;
+        origin[index]     = playhead.origin;
+        next[index]       = playhead.getNextMoveTime();
+        interval[index]   = static_cast<uint32_t>(playhead.getMoveInterval());
+        multiplier[index] = playhead.multiplier;
+        divider[index]    = playhead.divider;
+        enabled[index]    = playhead.enabled;
+        selected[index]   = playhead.selected;
+    }
+
+// MARK: - Simulation
+
+public:
+    /// @brief Recompute the time of each playhead's next move from its origin and its number of moves, and regroup the playheads.
+    /// @note  This should be called whenever playheads are added, removed, or modified, or their moves are restored.
+
+    inline void schedule() noexcept
+    {
+        const size_t count = size();
+
+        members.clear();
+        groups.clear();
+
+        for (size_t k = 0; k < count; ++k)
+        {
+            next[k] = origin[k] * EnginePlayhead::TICK_RESOLUTION + moves[k] * interval[k];
+            members.push_back(static_cast<uint32_t>(k));
+        }
+
+        std::sort(members.begin(), members.end(), [this](uint32_t a, uint32_t b)
+        {
+            return next[a] < next[b] || (next[a] == next[b] && (interval[a] < interval[b] || (interval[a] == interval[b] && a < b)));
+        });
+
+        for (size_t k = 0; k < count; ++k)
+        {
+            const uint32_t index = members[k];
+
+            if (groups.empty() || groups.back().time != next[index] || groups.back().interval != interval[index])
+            {
+                groups.push_back({next[index], interval[index], static_cast<uint32_t>(k), static_cast<uint32_t>(k)});
+            }
+
+            groups.back().end = static_cast<uint32_t>(k + 1);
+        }
+
+        std::make_heap(groups.begin(), groups.end(), std::greater<Group>());
+    }
+
+    /// @brief Count every move of each playhead before the given time without moving the playheads, e.g., when their positions
+    ///        have been restored from a recording of the same moves.
+    /// @param time The time in units of `1 / EnginePlayhead::TICK_RESOLUTION` ticks.
+
+    inline void elapse(uint64_t time) noexcept
+    {
+        while (!groups.empty() && groups.front().time < time)
+        {
+            std::pop_heap(groups.begin(), groups.end(), std::greater<Group>());
+
+            Group & group = groups.back();
+            const uint64_t due = (time - group.time + group.interval - 1) / group.interval;
+
+            for (uint32_t j = group.begin; j < group.end; ++j)
+            {
+                const uint32_t k = members[j];
+
+                moves[k] = moves[k] + due;
+                next[k]  = next[k] + due * interval[k];
+            }
+
+            group.time = group.time + due * group.interval;
+            std::push_heap(groups.begin(), groups.end(), std::greater<Group>());
+        }
+    }
+
+    /// @brief Return the time of the earliest move of any playhead, or the greatest possible time if no playhead is scheduled.
+
+    inline uint64_t getEarliestMoveTime() const noexcept
+    {
+        return groups.empty() ? std::numeric_limits<uint64_t>::max() : groups.front().time;
+    }
+
+    /// @brief Move each playhead whose next move is due at the given time by its direction, wrapping around the edges of the grid.
+    /// @param time The time in units of `1 / EnginePlayhead::TICK_RESOLUTION` ticks.
+    /// @param gridSize The dimensions of the grid in rows and columns.
+    /// @param indices A buffer to which the index of each playhead that moved is written in order.
+    /// @param earliest The time of the earliest move of any playhead after the playheads have been advanced.
+    /// @return The number of playheads that moved.
+
+    inline size_t advance(uint64_t time, const UISize<int>& gridSize, uint32_t* indices, uint64_t& earliest) noexcept
+    {
+        const int32_t w = gridSize.w;
+        const int32_t h = gridSize.h;
+
+        size_t moved  = 0;
+        size_t merged = 0;
+
+        while (!groups.empty() && groups.front().time == time)
+        {
+            std::pop_heap(groups.begin(), groups.end(), std::greater<Group>());
+
+            Group & group = groups.back();
+            std::copy(members.begin() + group.begin, members.begin() + group.end, indices + moved);
+
+            moved  = moved + (group.end - group.begin);
+            merged = merged + 1;
+
+            group.time = group.time + group.interval;
+            std::push_heap(groups.begin(), groups.end(), std::greater<Group>());
+        }
+
+        // The members of each group are in order, but the members of groups that are due at the same time are interleaved,
+        // so they're marked and then collected in order.
+
+        if (merged > 1)
+        {
+            for (size_t j = 0; j < moved; ++j)
+            {
+                due[indices[j] >> 6] |= uint64_t(1) << (indices[j] & 63);
+            }
+
+            moved = 0;
+
+            for (size_t word = 0; word < due.size(); ++word)
+            {
+                for (uint64_t bits = due[word]; bits != 0; bits = bits & (bits - 1))
+                {
+                    indices[moved++] = static_cast<uint32_t>(word * 64 + __builtin_ctzll(bits));
+                }
+
+                due[word] = 0;
+            }
+        }
+
+        for (size_t j = 0; j < moved; ++j)
+        {
+            const uint32_t k = indices[j];
+
+            int32_t u = x[k] + dx[k];
+            int32_t v = y[k] + dy[k];
+
+            u = u + (w & -(u < 0)) - (w & -(u >= w));
+            v = v + (h & -(v < 0)) - (h & -(v >= h));
+
+            x[k]     = u;
+            y[k]     = v;
+            moves[k] = moves[k] + 1;
+            next[k]  = next[k] + interval[k];
+        }
+
+        earliest = getEarliestMoveTime();
+
+        return moved;
+    }
+
+public:
+    std::vector<int32_t>  x;
+    std::vector<int32_t>  y;
+    std::vector<int32_t>  dx;
+    std::vector<int32_t>  dy;
+
+    /// @brief The number of moves each playhead has made since its origin.
+
+    std::vector<uint64_t> moves;
+
+    /// @brief The absolute tick of each playhead's first move at its current rate.
+
+    std::vector<uint64_t> origin;
+
+    /// @brief The time of each playhead's next move in units of `1 / EnginePlayhead::TICK_RESOLUTION` ticks.
+
+    std::vector<uint64_t> next;
+
+    /// @brief The time between each playhead's successive moves in units of `1 / EnginePlayhead::TICK_RESOLUTION` ticks.
+
+    std::vector<uint32_t> interval;
+
+    std::vector<uint8_t>  multiplier;
+    std::vector<uint8_t>  divider;
+    std::vector<uint8_t>  enabled;
+    std::vector<uint8_t>  selected;
+
+private:
+    /// @brief The indices of the playheads, ordered by group.
+
+    std::vector<uint32_t> members;
+
+    /// @brief The groups of playheads that move in lockstep, ordered as a min-heap by the time of each group's next move.
+
+    std::vector<Group> groups;
+
+    /// @brief A bit for each playhead that's due, which is only set while the members of several groups are being ordered.
+
+    std::vector<uint64_t> due;
+};
+
+#endif
@@ -0,0 +1,79 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef ENGINERANDOM_H
+#define ENGINERANDOM_H
+
+#include <cstdint>
+#include "UIPoint.h"
+
+/// @brief A counter-based source of random numbers for the nodes of the sequencer engine.
+/// @note  Each number is a hash of the engine's seed, the position of the node that draws it, and the number of numbers the node
+///        has drawn before, so a node's choices depend on nothing else, e.g., the order in which playheads are processed. Drawing
+///        a number doesn't modify the source, so numbers can be drawn from any thread, and the same seed reproduces the same choices.
+///        A Random redirect's counter is 16 bits wide, so its choices repeat with a period of 65,536 visits. This is deliberate:
+///        a node's choices are determined by its stored state alone, which lets the engine detect and replay cycles and restore
+///        the node from a saved project, and keeps each node within eight bytes.
+
+class EngineRandom
+{
+public:
+    EngineRandom(uint64_t seed = 0)
+    {
+        setSeed(seed);
+    }
+
+    /// @brief Set the seed from which every number is derived.
+    /// @param seed The seed, e.g., a project's seed.
+
+    inline void setSeed(uint64_t seed) noexcept
+    {
+        this->seed = seed;
+        this->key  = mix(seed + GOLDEN_RATIO);
+    }
+
+    /// @brief Return the seed from which every number is derived.
+
+    inline uint64_t getSeed() const noexcept
+    {
+        return seed;
+    }
+
+    /// @brief Return a random number in the range [0, n).
+    /// @param xy The position of the node that's drawing the number.
+    /// @param counter The number of numbers the node has drawn before.
+    /// @param n The number of possible outcomes, which must be greater than zero.
+
+    inline uint32_t draw(const UIPoint<int>& xy, uint32_t counter, uint32_t n) const noexcept
+    {
+        const uint64_t x = static_cast<uint16_t>(xy.x);
+        const uint64_t y = static_cast<uint16_t>(xy.y);
+        const uint64_t z = mix(key ^ (x << 48 | y << 32 | counter));
+
+        // The top 32 bits are scaled to the range by multiplication, which avoids the cost of a division.
+
+        return static_cast<uint32_t>(((z >> 32) * n) >> 32);
+    }
+
+public:
+    /// @brief Scramble the bits of the given integer with the finaliser of the SplitMix64 generator.
+
+    inline static uint64_t mix(uint64_t z) noexcept
+    {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+private:
+    constexpr static uint64_t GOLDEN_RATIO = 0x9E3779B97F4A7C15ull;
+
+private:
+    uint64_t seed;
+
+    /// @brief The scrambled seed.
+
+    uint64_t key;
+};
+
+#endif
@@ -0,0 +1,80 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef ENGINESNAPSHOT_H
+#define ENGINESNAPSHOT_H
+
+#include <vector>
+#include <cstdint>
+#include "UISize.h"
+#include "EngineNode.h"
+#include "EnginePlayhead.h"
+#include "EngineSubsequence.h"
+
+/// @brief A copy of the sequencer engine's state from which the UI can be drawn without touching the engine.
+/// @note  Storage for the greatest number of nodes and playheads is reserved up front, so a snapshot can be written
+///        by the clock's thread without allocating memory.
+
+struct EngineSnapshot
+{
+    /// @brief Construct a snapshot with room for the given number of nodes and playheads.
+    /// @param nodes The maximum number of nodes.
+    /// @param playheads The maximum number of playheads.
+
+    EngineSnapshot(size_t nodes, size_t playheads)
+    {
+        this->nodes.reserve(nodes);
+        this->positions.reserve(nodes);
+        this->playheads.reserve(playheads);
+    }
+
+    /// @brief The dimensions of the grid in rows and columns.
+
+    UISize<int> gridSize;
+
+    /// @brief Every node on the grid.
+
+    std::vector<EngineNode> nodes;
+
+    /// @brief The position of each node as column and row indices, in the same order as `nodes`.
+
+    std::vector<UIPoint<int>> positions;
+
+    /// @brief Every playhead, at the position it had after the most recently dispatched tick.
+
+    std::vector<EnginePlayhead> playheads;
+
+    /// @brief The cell whose contents are described in full, which is usually the cell under the user's cursor.
+
+    UIPoint<int> focus;
+
+    /// @brief Whether the focused cell contains a node or not.
+
+    bool hasFocusNode = false;
+
+    /// @brief The node in the focused cell.
+
+    EngineNode focusNode;
+
+    /// @brief The notes of the node in the focused cell if it's a subsequence.
+
+    EngineSubsequence focusSubsequence;
+
+    /// @brief The number of edits that have been applied to the engine.
+
+    uint64_t revision = 0;
+
+    /// @brief The absolute index of the next tick to be dispatched, which the sequencer replaces with the transport's tick.
+
+    uint64_t tick = 0;
+
+    /// @brief The number of ticks after which the music repeats itself exactly, or zero if no cycle has been found since the most recent edit.
+
+    uint64_t cycleLength = 0;
+
+    /// @brief The index of the pattern of the sequencer's bank whose engine wrote the snapshot.
+
+    size_t pattern = 0;
+};
+
+#endif
@@ -0,0 +1,66 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef ENGINESUBSEQUENCE_H
+#define ENGINESUBSEQUENCE_H
+
+#include <array>
+#include <cstdint>
+#include "MIDINote.h"
+
+/// @brief The notes of a subsequence node, which are broadcast one at a time, in order, by successive interactions.
+/// @note  Storage for every note is part of the record, so editing a subsequence never allocates or frees memory.
+
+struct EngineSubsequence
+{
+    std::array<MIDINote, 64> notes;
+
+    /// @brief The number of notes in the subsequence, which occupy the leading elements of `notes`.
+
+    uint8_t length = 0;
+
+    /// @brief The index of the note that will be broadcast by the next interaction.
+
+    uint8_t index = 0;
+
+public:
+    /// @brief Place a note at the given position, which can be at most one position after the last note.
+    /// @param position The index of the note to be modified or appended.
+    /// @param note The note to be placed.
+    /// @return A Boolean value to indicate whether the note was placed or not.
+
+    inline bool placeNote(size_t position, const MIDINote& note) noexcept
+    {
+        if (position < length)
+        {
+            notes[position] = note;
+            return true;
+        }
+
+        if (length == notes.size())
+            return false;
+
+        notes[length] = note;
+        length = length + 1;
+
+        return true;
+    }
+
+    /// @brief Erase the note at the given position, unless it's the subsequence's only note.
+    /// @param position The index of the note to be erased.
+
+    inline void eraseNote(size_t position) noexcept
+    {
+        if (length <= 1 || position >= length) return;
+
+        for (size_t k = position + 1; k < length; ++k)
+        {
+            notes[k - 1] = notes[k];
+        }
+
+        length = length - 1;
+        index  = index % length;
+    }
+};
+
+#endif
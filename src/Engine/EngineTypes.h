@@ -0,0 +1,12 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef ENGINETYPES_H
+#define ENGINETYPES_H
+
+#include "EngineNode.h"
+#include "EnginePlayhead.h"
+#include "EngineSubsequence.h"
+#include "EngineSnapshot.h"
+
+#endif
@@ -0,0 +1,105 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#include "EngineWorkers.hpp"
+
+EngineWorkers::EngineWorkers(size_t threads)
+{
+    threads = std::max<size_t>(1, std::min(threads, MAXIMUM_THREADS));
+
+    this->threads.reserve(threads - 1);
+
+    for (size_t k = 1; k < threads; ++k)
+    {
+        this->threads.emplace_back(&EngineWorkers::work, this, k);
+    }
+}
+
+EngineWorkers::~EngineWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running.store(false);
+    }
+
+    condition.notify_all();
+
+    for (auto & thread : threads)
+    {
+        thread.join();
+    }
+}
+
+EngineWorkers& EngineWorkers::shared() noexcept(false)
+{
+    static EngineWorkers workers(std::thread::hardware_concurrency());
+
+    return workers;
+}
+
+void EngineWorkers::start() noexcept
+{
+    remaining.store(threads.size(), std::memory_order_relaxed);
+
+    // Both counters are sequentially consistent, so either a parking thread sees the new batch before it waits,
+    // or the batch's publisher sees the parking thread and wakes it.
+
+    generation.fetch_add(1);
+
+    if (parked.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        condition.notify_all();
+    }
+}
+
+void EngineWorkers::wait() noexcept
+{
+    while (remaining.load(std::memory_order_acquire) > 0)
+    {
+        std::this_thread::yield();
+    }
+}
+
+void EngineWorkers::work(size_t index) noexcept
+{
+    uint64_t seen = 0;
+
+    while (true)
+    {
+        // Wait for the next batch, spinning at first in case it follows closely behind the previous batch.
+
+        size_t spins = 0;
+
+        while (generation.load(std::memory_order_acquire) == seen && running.load(std::memory_order_relaxed) && spins++ < SPIN_ITERATIONS)
+        {
+            std::this_thread::yield();
+        }
+
+        if (generation.load(std::memory_order_acquire) == seen && running.load(std::memory_order_relaxed))
+        {
+            parked.fetch_add(1);
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [&]() { return generation.load() != seen || !running.load(); });
+            }
+
+            parked.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        if (!running.load())
+        {
+            return;
+        }
+
+        seen = generation.load(std::memory_order_acquire);
+
+        const size_t count = batch.count;
+        const size_t parts = size();
+
+        batch.invoke(batch.context, count * index / parts, count * (index + 1) / parts);
+
+        remaining.fetch_sub(1, std::memory_order_release);
+    }
+}
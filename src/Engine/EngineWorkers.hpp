@@ -0,0 +1,135 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef ENGINEWORKERS_HPP
+#define ENGINEWORKERS_HPP
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+#include <condition_variable>
+
+/// @brief A fixed pool of threads that help the thread that owns the sequencer engine to process a range of independent jobs.
+/// @note  The threads are started when the pool is constructed, so running jobs never allocates memory. The calling thread processes
+///        the first part of the range itself and returns once every part has been processed. A batch is published by incrementing
+///        an atomic counter. Idle threads spin on the counter briefly after each batch, since the engine tends to run several batches
+///        per tick, and then park until they're woken. The pool's lock is only taken to wake parked threads, so a batch that follows
+///        closely behind another is published without a lock or a system call, and an idle pool uses no CPU time. One pool is shared
+///        by every engine, and a batch that's run while another thread is using the pool is processed by the calling thread alone,
+///        which gives the same result.
+
+class EngineWorkers
+{
+public:
+    /// @brief Construct a pool that processes jobs on the given number of threads, including the calling thread.
+    /// @param threads The number of threads, which is clamped between 1 and `MAXIMUM_THREADS`.
+
+     EngineWorkers(size_t threads);
+    ~EngineWorkers();
+
+    EngineWorkers(const EngineWorkers&) = delete;
+    EngineWorkers& operator = (const EngineWorkers&) = delete;
+
+    /// @brief Return the pool that's shared by every engine, which is created on first use with one thread per hardware thread.
+
+    static EngineWorkers& shared() noexcept(false);
+
+public:
+    /// @brief Return the number of threads that process jobs, including the calling thread.
+
+    inline size_t size() const noexcept
+    {
+        return threads.size() + 1;
+    }
+
+    /// @brief Process the jobs of the given range in contiguous parts, one part per thread, and wait until every part has been processed.
+    /// @param count The number of jobs.
+    /// @param job A callable object that accepts the beginning and the end of a part of the range. Parts are processed concurrently,
+    ///        so the callable must only write data that belongs to the jobs of its part.
+
+    template <typename Job>
+    void run(size_t count, Job && job) noexcept
+    {
+        if (threads.empty() || count < size() || busy.test_and_set(std::memory_order_acquire))
+        {
+            return job(size_t(0), count);
+        }
+
+        using Callable = typename std::remove_reference<Job>::type;
+
+        batch.invoke  = [](void* context, size_t begin, size_t end) { (*static_cast<Callable*>(context))(begin, end); };
+        batch.context = static_cast<void*>(&job);
+        batch.count   = count;
+
+        start();
+        job(size_t(0), count / size());
+        wait();
+
+        busy.clear(std::memory_order_release);
+    }
+
+public:
+    /// @brief The greatest number of threads that process jobs, including the calling thread.
+
+    constexpr static size_t MAXIMUM_THREADS = 16;
+
+private:
+    /// @brief Publish the current batch to the pool's threads.
+
+    void start() noexcept;
+
+    /// @brief Wait until each of the pool's threads has processed its part of the current batch.
+
+    void wait() noexcept;
+
+    /// @brief Process a part of each batch until the pool is destroyed.
+    /// @param index The index of the thread's part of each batch, which is at least 1.
+    /// @note  This is the body of each of the pool's threads.
+
+    void work(size_t index) noexcept;
+
+private:
+    /// @brief A range of jobs and a type-erased pointer to the callable that processes them.
+
+    struct Batch
+    {
+        void (*invoke)(void*, size_t, size_t) = nullptr;
+        void * context = nullptr;
+        size_t count   = 0;
+    };
+
+    /// @brief The number of times an idle thread checks for a new batch before it parks.
+
+    constexpr static size_t SPIN_ITERATIONS = 4096;
+
+private:
+    Batch batch;
+
+    /// @brief The number of batches that have been published, which is incremented to wake the pool's threads.
+
+    std::atomic<uint64_t> generation = {0};
+
+    /// @brief The number of the pool's threads that haven't finished processing their part of the current batch.
+
+    std::atomic<size_t> remaining = {0};
+
+    std::atomic<bool> running = {true};
+
+    /// @brief Whether a thread is running a batch on the pool, which is set by the thread that publishes the batch.
+
+    std::atomic_flag busy = ATOMIC_FLAG_INIT;
+
+    /// @brief The number of the pool's threads that are parked or about to park, which must be woken when a batch is published.
+
+    std::atomic<size_t> parked = {0};
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<std::thread> threads;
+};
+
+#endif
@@ -0,0 +1,142 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#include "SequencerBank.hpp"
+#include <algorithm>
+
+static_assert(SequencerBank::MAXIMUM_PATTERNS < 0xFFFF, "Pattern indices should be packed into 16 bits.");
+
+SequencerBank::SequencerBank()
+{
+    patterns[0] = std::make_unique<SequencerEngine>();
+}
+
+// MARK: - Inactive patterns
+
+SequencerEngine* SequencerBank::getPattern(size_t index) noexcept(false)
+{
+    // The active and queued patterns are read from one state, since a pattern can only become active after it has been queued.
+
+    const uint64_t current = state.load(std::memory_order_acquire);
+
+    if (index >= MAXIMUM_PATTERNS || index == current >> 48 || index == (current >> 32 & 0xFFFF))
+    {
+        return nullptr;
+    }
+
+    if (patterns[index] == nullptr)
+    {
+        patterns[index] = std::make_unique<SequencerEngine>();
+        patterns[index]->releaseLookahead();
+    }
+
+    return patterns[index].get();
+}
+
+bool SequencerBank::queue(size_t index, uint32_t quantum) noexcept
+{
+    if (index >= MAXIMUM_PATTERNS || patterns[index] == nullptr)
+    {
+        return false;
+    }
+
+    uint64_t current = state.load(std::memory_order_acquire);
+
+    // The queued pattern is replaced in one step, so the clock's thread either switches to the previously queued pattern
+    // or sees the new request, and never switches to a pattern that the UI thread has taken back.
+
+    do
+    {
+        const uint64_t active = current >> 48;
+
+        if (active == index)
+        {
+            return false;
+        }
+
+        const uint64_t next = pack(active, index, std::max<uint32_t>(quantum, 1));
+
+        if (state.compare_exchange_weak(current, next, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            return true;
+        }
+    }
+    while (true);
+}
+
+void SequencerBank::cancel() noexcept
+{
+    uint64_t current = state.load(std::memory_order_acquire);
+
+    while (!state.compare_exchange_weak(current, pack(current >> 48, UNQUEUED, 1),
+                                        std::memory_order_acq_rel, std::memory_order_acquire));
+}
+
+void SequencerBank::release() noexcept
+{
+    // A pattern that's neither active nor queued can only be handed to the clock's thread by the UI thread, so it can be
+    // released even if the clock's thread switches patterns meanwhile.
+
+    const uint64_t current = state.load(std::memory_order_acquire);
+
+    for (size_t k = 0; k < MAXIMUM_PATTERNS; ++k)
+    {
+        if (patterns[k] != nullptr && k != current >> 48 && k != (current >> 32 & 0xFFFF))
+        {
+            patterns[k]->releaseLookahead();
+        }
+    }
+}
+
+// MARK: - Switching
+
+bool SequencerBank::advance() noexcept
+{
+    uint64_t current = state.load(std::memory_order_acquire);
+
+    // A span begins at each multiple of the queued number of ticks on the transport, which is moved by seeking and loading
+    // as well as by playing. Only this thread switches the active pattern, so the transport is read once. If the UI thread
+    // replaces the queued switch while it's being applied, the replacement is applied instead if its span also begins here.
+
+    const uint64_t tick = getTransportTick();
+
+    while ((current >> 32 & 0xFFFF) != UNQUEUED && tick % (current & 0xFFFFFFFF) == 0)
+    {
+        if (swap(current))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool SequencerBank::commit() noexcept
+{
+    uint64_t current = state.load(std::memory_order_acquire);
+
+    while ((current >> 32 & 0xFFFF) != UNQUEUED)
+    {
+        if (swap(current)) return true;
+    }
+
+    return false;
+}
+
+bool SequencerBank::swap(uint64_t& current) noexcept
+{
+    const uint64_t queued = current >> 32 & 0xFFFF;
+    const uint64_t tick   = getTransportTick();
+
+    if (!state.compare_exchange_weak(current, pack(queued, UNQUEUED, 1), std::memory_order_acq_rel, std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    // The incoming pattern resumes from its own position, which is mapped onto the transport's current tick, so the transport
+    // carries on from where the outgoing pattern left it.
+
+    setTransportTick(tick);
+
+    return true;
+}
@@ -0,0 +1,169 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef SEQUENCERBANK_HPP
+#define SEQUENCERBANK_HPP
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <limits>
+#include <cstdint>
+#include "SequencerEngine.hpp"
+
+/// @brief A bank of patterns, each of which is a preloaded sequencer engine, one of which is active at a time.
+/// @note  The active pattern is owned by the thread that owns the sequencer's engine, i.e., the clock's thread while the clock
+///        ticks, and every other pattern is owned by the UI thread, which can load and edit it freely. A switch is queued by handing
+///        a pattern to the clock's thread, which makes it active at the first tick of the next beat or bar by swapping a single
+///        atomic word that holds both the active pattern and the queued pattern. Switching therefore never allocates memory, parses
+///        a file, or simulates more than the clock's thread would simulate anyway, so a pattern change never delays a tick. The pattern
+///        that was active is handed back to the UI thread by the same swap. Each pattern keeps its own position, so a pattern that's
+///        switched away from resumes where it stopped, but every pattern is played on the bank's one transport: the active pattern's
+///        timeline is mapped onto the transport by an offset that's recomputed whenever a pattern is swapped in, so the transport
+///        advances steadily across switches and every switch is quantised against it. Every pattern shares one pool of threads, and
+///        only the active and queued patterns hold the memory that's used to simulate ticks ahead of the clock.
+
+class SequencerBank
+{
+public:
+    /// @brief Construct a bank whose first pattern is an empty engine and is active.
+
+    SequencerBank();
+
+    SequencerBank(const SequencerBank&) = delete;
+    SequencerBank& operator = (const SequencerBank&) = delete;
+
+// MARK: - Active pattern
+
+public:
+    /// @brief Return the engine of the active pattern.
+    /// @note  This should be called by the thread that owns the sequencer's engine.
+
+    inline SequencerEngine& getActive() noexcept
+    {
+        return *patterns[getActiveIndex()];
+    }
+
+    /// @brief Return the transport's tick, i.e., the tick that the active pattern is about to dispatch on the bank's shared timeline.
+    /// @note  This should be called by the thread that owns the sequencer's engine. The transport moves with the active pattern,
+    ///        so it's advanced by playing and seeking the active pattern.
+
+    inline uint64_t getTransportTick() const noexcept
+    {
+        return patterns[getActiveIndex()]->getPosition() - static_cast<uint64_t>(offset);
+    }
+
+    /// @brief Move the transport to the given tick without moving the active pattern, e.g., once a project has been loaded
+    ///        into the active pattern.
+    /// @param tick The transport's new tick.
+    /// @note  This should be called by the thread that owns the sequencer's engine.
+
+    inline void setTransportTick(uint64_t tick) noexcept
+    {
+        offset = static_cast<int64_t>(patterns[getActiveIndex()]->getPosition() - tick);
+    }
+
+    /// @brief Return the index of the active pattern.
+
+    inline size_t getActiveIndex() const noexcept
+    {
+        return static_cast<size_t>(state.load(std::memory_order_acquire) >> 48);
+    }
+
+    /// @brief Return the index of the pattern that's queued to become active, or `None` if no switch is queued.
+
+    inline size_t getQueuedIndex() const noexcept
+    {
+        const size_t index = static_cast<size_t>(state.load(std::memory_order_acquire) >> 32 & 0xFFFF);
+
+        return index == UNQUEUED ? None : index;
+    }
+
+// MARK: - Inactive patterns
+
+public:
+    /// @brief Return the engine of the given pattern, which is created without a lookahead if it doesn't exist yet.
+    /// @param index The index of the pattern.
+    /// @return The engine, or nullptr if the index is out of range or the pattern is active or queued to become active.
+    /// @note  This should be called by the UI thread, which owns the returned engine until it's queued.
+    /// @throw An exception will be thrown if the pattern's engine can't be allocated.
+
+    SequencerEngine* getPattern(size_t index) noexcept(false);
+
+    /// @brief Queue a switch to the given pattern at the first tick of the next span of the given number of ticks on the transport,
+    ///        e.g., the next beat or bar, replacing any switch that's already queued.
+    /// @param index The index of the pattern, which must have been created by `getPattern`.
+    /// @param quantum The number of ticks per beat or bar.
+    /// @return A Boolean value to indicate whether the switch was queued or not.
+    /// @note  This should be called by the UI thread. The pattern is owned by the clock's thread from the moment it's queued,
+    ///        so its lookahead should be reserved and simulated beforehand.
+
+    bool queue(size_t index, uint32_t quantum) noexcept;
+
+    /// @brief Cancel the queued switch, if any, returning the queued pattern to the UI thread.
+
+    void cancel() noexcept;
+
+    /// @brief Release the lookahead of every pattern that's neither active nor queued.
+    /// @note  This should be called by the UI thread, e.g., once a switch has been made or cancelled.
+
+    void release() noexcept;
+
+// MARK: - Switching
+
+public:
+    /// @brief Make the queued pattern active if the transport's tick begins a span of the queued number of ticks.
+    /// @return A Boolean value to indicate whether the active pattern was switched or not.
+    /// @note  This should be called by the thread that owns the sequencer's engine at the start of each tick, before the tick is dispatched.
+
+    bool advance() noexcept;
+
+    /// @brief Make the queued pattern active immediately, e.g., when the clock is stopped.
+    /// @return A Boolean value to indicate whether the active pattern was switched or not.
+    /// @note  This should be called by the thread that owns the sequencer's engine.
+
+    bool commit() noexcept;
+
+public:
+    /// @brief The number of patterns in the bank.
+
+    constexpr static size_t MAXIMUM_PATTERNS = 16;
+
+    /// @brief The index returned when no pattern is queued.
+
+    constexpr static size_t None = std::numeric_limits<size_t>::max();
+
+private:
+    /// @brief The value of the queued index in the bank's state when no pattern is queued.
+
+    constexpr static uint64_t UNQUEUED = 0xFFFF;
+
+    /// @brief Pack the active index, the queued index, and the queued switch's span into the bank's state.
+
+    inline static uint64_t pack(uint64_t active, uint64_t queued, uint64_t quantum) noexcept
+    {
+        return active << 48 | queued << 32 | quantum;
+    }
+
+    /// @brief Replace the bank's state with the queued pattern if the given state has a queued switch, and map the queued pattern's
+    ///        timeline onto the transport.
+    /// @param current The most recently loaded state, which is updated if the swap fails.
+
+    bool swap(uint64_t& current) noexcept;
+
+private:
+    /// @brief The engine of each pattern, which is created by the UI thread when the pattern is first requested.
+
+    std::array<std::unique_ptr<SequencerEngine>, MAXIMUM_PATTERNS> patterns;
+
+    /// @brief The active pattern's index in the upper 16 bits, the queued pattern's index in the next 16 bits, and the number of
+    ///        ticks per span of the queued switch in the lower 32 bits.
+
+    std::atomic<uint64_t> state = {pack(0, UNQUEUED, 1)};
+
+    /// @brief The active pattern's position minus the transport's tick, which is only accessed by the thread that owns the active pattern.
+
+    int64_t offset = 0;
+};
+
+#endif
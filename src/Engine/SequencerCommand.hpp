@@ -0,0 +1,76 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef SEQUENCERCOMMAND_HPP
+#define SEQUENCERCOMMAND_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "UIPoint.h"
+#include "MIDINote.h"
+#include "EngineNode.h"
+
+/// @brief An edit to the contents of the Ensemble sequencer.
+/// @note  Commands are created on the UI thread and applied to the sequencer engine by the thread that owns the engine,
+///        which is the clock's thread while the clock is ticking. A command is a plain record, so submitting one never allocates memory.
+
+typedef struct SequencerCommand
+{
+    /// @brief Constants defining the kinds of edits that can be made to the sequencer.
+
+    enum Type
+    {
+        PlaceNote,
+        PlaceNode,
+        PlacePortal,
+        PlacePlayhead,
+        Erase,
+        ErasePlayhead,
+        TogglePlayhead,
+        SelectPlayhead,
+        SetPlayheadRate,
+        CyclePlayheadRate,
+        SetSeed,
+        Resize
+    };
+    
+    /// @brief The kind of edit.
+
+    Type type = PlaceNode;
+    
+    /// @brief The grid position of the edit.
+    /// @note  The dimensions of the grid in columns and rows in the case of a `Resize` command,
+    ///        or the multiplier and divider of a playhead's rate in the case of a `SetPlayheadRate` command.
+
+    UIPoint<int> xy;
+    
+    /// @brief The direction of the playhead to be placed by a `PlacePlayhead` command.
+
+    UIPoint<int> delta;
+    
+    /// @brief The type of redirect to be placed by a `PlaceNode` command.
+
+    Redirection redirection = Redirection::X;
+    
+    /// @brief The note to be placed by a `PlaceNote` command.
+
+    MIDINote note;
+    
+    /// @brief The index of the playhead targeted by a playhead command,
+    ///        or the position within an expanded subsequence targeted by a `PlaceNote` or `Erase` command.
+    /// @note  An index that's out of range is discarded by the engine.
+
+    size_t index = 0;
+    
+    /// @brief Whether a `PlaceNote` or `Erase` command targets an expanded subsequence, the new state of a `SelectPlayhead` command,
+    ///        or whether a `CyclePlayheadRate` command targets the multiplier rather than the divider.
+
+    bool flag = false;
+
+    /// @brief The seed of the choices made by Random redirects to be set by a `SetSeed` command.
+
+    uint64_t seed = 0;
+
+} SequencerCommand;
+
+#endif
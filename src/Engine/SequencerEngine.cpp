@@ -0,0 +1,1106 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#include "SequencerEngine.hpp"
+
+SequencerEngine::SequencerEngine():
+SequencerEngine(EngineWorkers::shared())
+{
+
+}
+
+SequencerEngine::SequencerEngine(EngineWorkers& workers):
+workers(workers)
+{
+    grid.reserve(MAXIMUM_TILES);
+    playheads.reserve(MAXIMUM_PLAYHEADS);
+    subsequences.reserve(MAXIMUM_SUBSEQUENCES);
+    freeSubsequences.reserve(MAXIMUM_SUBSEQUENCES);
+    unpairedPortals.reserve(MAXIMUM_NODES);
+    reserveLookahead();
+}
+
+SequencerEngine::SequencerEngine(const SequencerEngine& other):
+grid(other.grid),
+playheads(other.playheads),
+subsequences(other.subsequences),
+freeSubsequences(other.freeSubsequences),
+unpairedPortals(other.unpairedPortals),
+gridSize(other.gridSize),
+lookahead(other.lookahead),
+moving(other.moving),
+paths(other.paths),
+workers(other.workers),
+scheduleIsStale(other.scheduleIsStale),
+loop(other.loop),
+nodeHash(other.nodeHash),
+nodeHashIsStale(other.nodeHashIsStale),
+revision(other.revision),
+random(other.random)
+{
+    playheads.reserve(MAXIMUM_PLAYHEADS);
+    subsequences.reserve(MAXIMUM_SUBSEQUENCES);
+    freeSubsequences.reserve(MAXIMUM_SUBSEQUENCES);
+    unpairedPortals.reserve(MAXIMUM_NODES);
+}
+
+// MARK: - Memory
+
+void SequencerEngine::reserveLookahead() noexcept(false)
+{
+    lookahead.allocate();
+    loop.allocate();
+    moving.resize(MAXIMUM_PLAYHEADS);
+    paths.resize(MAXIMUM_PLAYHEADS);
+}
+
+void SequencerEngine::releaseLookahead() noexcept
+{
+    // The simulated ticks are rewound rather than discarded, since the playheads and nodes have already been moved by them.
+
+    rewind();
+
+    lookahead.deallocate();
+    loop.deallocate();
+    std::vector<uint32_t>().swap(moving);
+    std::vector<Path>().swap(paths);
+}
+
+// MARK: - Simulation
+
+void SequencerEngine::simulate(size_t ticks) noexcept
+{
+    // Edits can add, remove, or rewind playheads, so the time of each playhead's next move is recomputed.
+
+    if (scheduleIsStale)
+    {
+        playheads.schedule();
+        scheduleIsStale = false;
+    }
+
+    // Edits can modify or rewind any node, so the hash of the nodes' states is recomputed before the next tick is hashed.
+
+    if (nodeHashIsStale)
+    {
+        rehash();
+        nodeHashIsStale = false;
+    }
+
+    while (lookahead.size() < ticks && lookahead.hasRoomFor(playheads.size()))
+    {
+        simulate();
+    }
+}
+
+void SequencerEngine::simulate() noexcept
+{
+    const uint64_t tick = lookahead.getSimulatedTick();
+    const uint64_t time = tick * EnginePlayhead::TICK_RESOLUTION;
+
+    const uint64_t end  = time + EnginePlayhead::TICK_RESOLUTION;
+
+    lookahead.begin(playheads);
+
+    if (loop.isReplaying())
+    {
+        replay(tick);
+        lookahead.end();
+        return;
+    }
+
+    uint64_t next = playheads.getEarliestMoveTime();
+
+    while (next < end)
+    {
+        lookahead.setOffset(static_cast<uint16_t>(next > time ? next - time : 0));
+
+        // Every playhead that's due moves at once, then each of them interacts with the cell it landed on in the order
+        // in which the playheads were placed. A move only depends on the playhead's own state, so this is equivalent to
+        // moving and interacting one playhead at a time.
+
+        const size_t count = playheads.advance(next, gridSize, moving.data(), next);
+
+        if (count < PARALLEL_THRESHOLD || workers.size() == 1)
+        {
+            for (size_t k = 0; k < count; ++k)
+            {
+                move(moving[k]);
+            }
+
+            continue;
+        }
+
+        // The paths of the playheads only read the grid, so they're resolved in parallel, and the effects of each path
+        // on the grid, the subsequences, and the lookahead are applied afterwards in the order in which the playheads were placed.
+
+        workers.run(count, [this](size_t begin, size_t end)
+        {
+            for (size_t k = begin; k < end; ++k)
+            {
+                resolve(moving[k], paths[k]);
+            }
+        });
+
+        for (size_t k = 0; k < count; ++k)
+        {
+            merge(moving[k], paths[k]);
+        }
+    }
+
+    lookahead.end();
+
+    loop.close(playheads);
+    loop.observe(tick + 1, hashState(tick + 1));
+}
+
+uint64_t SequencerEngine::skip(uint64_t ticks) noexcept
+{
+    if (!lookahead.isEmpty())
+    {
+        return 0;
+    }
+
+    const uint64_t tick = lookahead.getSimulatedTick();
+
+    for (size_t k = 0; k < playheads.size(); ++k)
+    {
+        const EnginePlayhead playhead = playheads.get(k);
+        const uint64_t moves = playhead.getNumberOfMovesBefore(tick + ticks) - playhead.moves;
+        const uint64_t distance = getDistanceToNextNode(playhead, moves);
+
+        if (distance == 0) continue;
+
+        // The playhead lands on a node during the tick of its `distance`th move, so every tick before that one can be skipped.
+
+        const uint64_t time = playhead.getMoveTime(playhead.moves + distance - 1);
+        const uint64_t end  = time / EnginePlayhead::TICK_RESOLUTION;
+
+        ticks = std::min(ticks, end > tick ? end - tick : 0);
+    }
+
+    if (ticks == 0)
+    {
+        return 0;
+    }
+
+    for (size_t k = 0; k < playheads.size(); ++k)
+    {
+        EnginePlayhead playhead = playheads.get(k);
+
+        const uint64_t end   = playhead.getNumberOfMovesBefore(tick + ticks);
+        const uint64_t moves = end - playhead.moves;
+        const int64_t  w = gridSize.w;
+        const int64_t  h = gridSize.h;
+
+        playhead.xy.x = static_cast<int>(((playhead.xy.x + static_cast<int64_t>(moves % w) * playhead.delta.x) % w + w) % w);
+        playhead.xy.y = static_cast<int>(((playhead.xy.y + static_cast<int64_t>(moves % h) * playhead.delta.y) % h + h) % h);
+        playhead.moves = end;
+
+        playheads.set(k, playhead);
+    }
+
+    lookahead.skip(ticks);
+    scheduleIsStale = true;
+
+    // The skipped ticks aren't recorded, so a cycle that hasn't been found yet must be sought again. A cycle that has been found
+    // still describes the simulation, since skipping ticks is equivalent to simulating them.
+
+    if (!loop.isReplaying())
+    {
+        loop.reset();
+    }
+
+    return ticks;
+}
+
+void SequencerEngine::seek(uint64_t ticks) noexcept
+{
+    const auto discard = [](const MIDINote &, uint16_t) {};
+
+    while (ticks > 0 && !lookahead.isEmpty())
+    {
+        lookahead.dispatch(discard);
+        ticks = ticks - 1;
+    }
+
+    // Each tick is simulated while a cycle that could be replayed is still being sought, since a skip restarts the search.
+    // Once the search has been abandoned, stretches of silence are skipped for the rest of the seek.
+
+    bool shouldSkip = false;
+
+    while (ticks > 0)
+    {
+        const uint64_t length = loop.getLength();
+
+        // The state at the start of each period of a cycle is the same, so only the playheads' moves need to be counted.
+
+        if (loop.isReplaying() && ticks >= length)
+        {
+            if (scheduleIsStale)
+            {
+                playheads.schedule();
+                scheduleIsStale = false;
+            }
+
+            const uint64_t periods = ticks - ticks % length;
+            const uint64_t tick    = lookahead.getSimulatedTick();
+
+            playheads.elapse((tick + periods) * EnginePlayhead::TICK_RESOLUTION);
+            lookahead.skip(periods);
+
+            ticks = ticks - periods;
+            continue;
+        }
+
+        shouldSkip = shouldSkip || !loop.isSearching();
+
+        if (const uint64_t skipped = shouldSkip ? skip(ticks) : 0)
+        {
+            ticks = ticks - skipped;
+            continue;
+        }
+
+        simulate(1);
+        lookahead.dispatch(discard);
+        ticks = ticks - 1;
+    }
+}
+
+uint64_t SequencerEngine::getDistanceToNextNode(const EnginePlayhead& playhead, uint64_t limit) const noexcept
+{
+    const UIPoint<int>& delta = playhead.delta;
+    const int w = gridSize.w;
+    const int h = gridSize.h;
+
+    if (limit == 0)
+        return 0;
+
+    // The search steps one cell at a time, so a playhead that moves further per move is assumed to land on a node.
+
+    if (std::abs(delta.x) > 1 || std::abs(delta.y) > 1)
+        return 1;
+
+    if (delta.x == 0 && delta.y == 0)
+        return getNode(playhead.xy) != nullptr ? 1 : 0;
+
+    // The playhead's path repeats after it has visited every cell of its row, column, or diagonal.
+
+    const uint64_t period = delta.x == 0 ? h : delta.y == 0 ? w : std::lcm(w, h);
+
+    limit = std::min(limit, period);
+
+    UIPoint<int> xy = playhead.xy;
+    uint64_t distance = 0;
+
+    while (distance < limit)
+    {
+        // The number of moves before the playhead wraps around an edge of the grid.
+
+        uint64_t span = limit - distance;
+
+        if (delta.x > 0) span = std::min<uint64_t>(span, w - 1 - xy.x);
+        if (delta.x < 0) span = std::min<uint64_t>(span, xy.x);
+        if (delta.y > 0) span = std::min<uint64_t>(span, h - 1 - xy.y);
+        if (delta.y < 0) span = std::min<uint64_t>(span, xy.y);
+
+        if (span > 0)
+        {
+            if (const unsigned int k = grid.scan(xy.x, xy.y, delta.x, delta.y, static_cast<unsigned int>(span)))
+                return distance + k;
+
+            xy.x = xy.x + static_cast<int>(span) * delta.x;
+            xy.y = xy.y + static_cast<int>(span) * delta.y;
+            distance = distance + span;
+        }
+
+        if (distance == limit)
+            break;
+
+        xy.x = (xy.x + delta.x + w) % w;
+        xy.y = (xy.y + delta.y + h) % h;
+        distance = distance + 1;
+
+        if (getNode(xy) != nullptr)
+            return distance;
+    }
+
+    return 0;
+}
+
+void SequencerEngine::move(size_t index) noexcept
+{
+    UIPoint<int> xy    = {playheads.x[index], playheads.y[index]};
+    UIPoint<int> delta = {playheads.dx[index], playheads.dy[index]};
+
+    const bool enabled = playheads.enabled[index];
+
+    walk(xy, delta, [this, enabled](UIPoint<int>& xy, UIPoint<int>& delta)
+    {
+        return interact(xy, delta, enabled);
+    });
+
+    playheads.x[index]  = xy.x;
+    playheads.y[index]  = xy.y;
+    playheads.dx[index] = delta.x;
+    playheads.dy[index] = delta.y;
+}
+
+void SequencerEngine::resolve(size_t index, Path& path) const noexcept
+{
+    UIPoint<int> xy    = {playheads.x[index], playheads.y[index]};
+    UIPoint<int> delta = {playheads.dx[index], playheads.dy[index]};
+
+    path.numberOfVisits  = 0;
+    path.isSelfDependent = false;
+
+    walk(xy, delta, [this, &path](UIPoint<int>& xy, UIPoint<int>& delta)
+    {
+        Visit & visit = path.visits[path.numberOfVisits++];
+
+        const bool complete = trace(getNode(xy), xy, delta, visit);
+
+        if (visit.occupied && visit.node.type == Redirect && visit.node.isStateful())
+        {
+            for (size_t k = 0; k + 1 < path.numberOfVisits; ++k)
+            {
+                if (path.visits[k].xy == visit.xy)
+                {
+                    path.isSelfDependent = true;
+                    return true;
+                }
+            }
+        }
+
+        return complete;
+    });
+
+    path.xy    = xy;
+    path.delta = delta;
+}
+
+void SequencerEngine::merge(size_t index, const Path& path) noexcept
+{
+    if (path.isSelfDependent)
+    {
+        return move(index);
+    }
+
+    for (size_t k = 0; k < path.numberOfVisits; ++k)
+    {
+        const Visit & visit = path.visits[k];
+
+        if (!visit.occupied || visit.node.type != Redirect || !visit.node.isStateful())
+            continue;
+
+        const EngineNode* node = find(visit.xy);
+
+        if (node->redirect.state != visit.node.redirect.state || node->redirect.choice != visit.node.redirect.choice)
+        {
+            return move(index);
+        }
+    }
+
+    const bool enabled = playheads.enabled[index];
+
+    for (size_t k = 0; k < path.numberOfVisits; ++k)
+    {
+        commit(path.visits[k], enabled);
+    }
+
+    playheads.x[index]  = path.xy.x;
+    playheads.y[index]  = path.xy.y;
+    playheads.dx[index] = path.delta.x;
+    playheads.dy[index] = path.delta.y;
+}
+
+bool SequencerEngine::interact(UIPoint<int>& xy, UIPoint<int>& delta, bool enabled) noexcept
+{
+    Visit visit;
+
+    const bool complete = trace(find(xy), xy, delta, visit);
+
+    commit(visit, enabled);
+
+    return complete;
+}
+
+bool SequencerEngine::trace(const EngineNode* node, UIPoint<int>& xy, UIPoint<int>& delta, Visit& visit) const noexcept
+{
+    visit.xy         = xy;
+    visit.occupied   = node != nullptr;
+    visit.redirected = false;
+
+    if (node == nullptr)
+    {
+        return true;
+    }
+
+    visit.node = *node;
+
+    switch (node->type)
+    {
+        case Redirect:
+        {
+            visit.redirected = redirect(*node, xy, delta);
+            return false;
+        }
+
+        case Portal:
+        {
+            teleport(*node, xy, delta);
+            return false;
+        }
+
+        case Subsequence: return true;
+
+        default: return false;
+    }
+}
+
+void SequencerEngine::commit(const Visit& visit, bool enabled) noexcept
+{
+    loop.record(visit, lookahead.getOffset(), enabled);
+    lookahead.visit(visit.xy);
+
+    if (!visit.occupied)
+    {
+        return;
+    }
+
+    switch (visit.node.type)
+    {
+        case Redirect:
+        {
+            lookahead.record({visit.xy, 0, visit.node.redirect.state, visit.node.redirect.choice, visit.node.redirect.counter});
+
+            if (visit.redirected && visit.node.isStateful())
+                cycle(*find(visit.xy), visit.xy);
+
+            return;
+        }
+
+        case Subsequence:
+        {
+            lookahead.record({visit.xy, subsequences[visit.node.subsequence.index].index});
+            play(visit.node, enabled);
+            return;
+        }
+
+        default: return;
+    }
+}
+
+bool SequencerEngine::redirect(const EngineNode& node, UIPoint<int>& xy, UIPoint<int>& delta) const noexcept
+{
+    if (delta.x == 0 && delta.y == 0)
+        return false;
+
+    const auto turn    = [&]() { delta.set(-delta.y, +delta.x); };
+    const auto reverse = [&]() { delta.set(-delta.x, -delta.y); };
+
+    switch (node.readBasicRedirectionType())
+    {
+        case Redirection::X:
+        {
+                 if (delta.x == 0) turn();
+            else if (delta.y == 0) reverse();
+            else delta.set(-delta.x, 0);
+            break;
+        }
+
+        case Redirection::Y:
+        {
+                 if (delta.x == 0) reverse();
+            else if (delta.y == 0) turn();
+            else delta.set(0, -delta.y);
+            break;
+        }
+
+        case Redirection::Diagonal:
+        {
+            if (delta.x == 0 || delta.y == 0)
+                 delta.set(delta.x == +1 ? -1 : +1, delta.y == -1 ? +1 : -1);
+            else turn();
+            break;
+        }
+
+        default: return false;
+    }
+
+    step(xy, delta);
+
+    return true;
+}
+
+void SequencerEngine::cycle(EngineNode& node, const UIPoint<int>& xy) noexcept
+{
+    nodeHash = nodeHash ^ hashNode(xy, node.redirect);
+
+    switch (node.redirect.redirection)
+    {
+        case Redirection::Alternating:
+        {
+            node.redirect.state = !node.redirect.state;
+            break;
+        }
+
+        case Redirection::Random:
+        {
+            node.redirect.counter = node.redirect.counter + 1;
+            node.redirect.choice  = static_cast<uint8_t>(random.draw(xy, node.redirect.counter, 3));
+            break;
+        }
+
+        default: break;
+    }
+
+    nodeHash = nodeHash ^ hashNode(xy, node.redirect);
+}
+
+void SequencerEngine::teleport(const EngineNode& node, UIPoint<int>& xy, const UIPoint<int>& delta) const noexcept
+{
+    if (node.portal.paired)
+    {
+        xy.x = (node.portal.x + delta.x + gridSize.w) % gridSize.w;
+        xy.y = (node.portal.y + delta.y + gridSize.h) % gridSize.h;
+        return;
+    }
+
+    // An unpaired portal teleports the playhead to the opposite end of its row, its column, or its diagonal.
+
+    const int w = gridSize.w;
+    const int h = gridSize.h;
+
+    if (delta.x == 0) { xy.y = delta.y > 0 ? 0 : h - 1; return; }
+    if (delta.y == 0) { xy.x = delta.x > 0 ? 0 : w - 1; return; }
+
+    if (delta.x < 0 && delta.y < 0)
+    {
+        const int k = std::min(w - xy.x - 1, h - xy.y - 1);
+        xy.set((xy.x + k) % w, (xy.y + k) % h);
+    }
+
+    else if (delta.x < 0 && delta.y > 0)
+    {
+        const int k = std::min(w - xy.x - 1, xy.y);
+        xy.set((xy.x + k) % w, (xy.y - k) % h);
+    }
+
+    else if (delta.x > 0 && delta.y < 0)
+    {
+        const int k = std::min(xy.x, h - xy.y - 1);
+        xy.set((xy.x - k) % w, (xy.y + k) % h);
+    }
+
+    else
+    {
+        const int k = std::min(xy.x, xy.y);
+        xy.set((xy.x - k) % w, (xy.y - k) % h);
+    }
+}
+
+void SequencerEngine::play(const EngineNode& node, bool enabled) noexcept
+{
+    EngineSubsequence & sequence = subsequences[node.subsequence.index];
+
+    if (sequence.length == 0)
+    {
+        return;
+    }
+
+    nodeHash = nodeHash ^ hashNode(node.subsequence.index);
+
+    sequence.index = sequence.index % sequence.length;
+
+    if (enabled)
+    {
+        lookahead.broadcast(sequence.notes[sequence.index]);
+    }
+
+    sequence.index = (sequence.index + 1) % sequence.length;
+
+    nodeHash = nodeHash ^ hashNode(node.subsequence.index);
+}
+
+void SequencerEngine::restore(const SequencerLookahead::NodeState& state) noexcept
+{
+    EngineNode* node = find(state.xy);
+
+    if (node == nullptr)
+    {
+        return;
+    }
+
+    switch (node->type)
+    {
+        case Redirect:
+        {
+            node->redirect.state  = state.state;
+            node->redirect.choice  = state.choice;
+            node->redirect.counter = state.counter;
+            return;
+        }
+
+        case Subsequence:
+        {
+            subsequences[node->subsequence.index].index = state.index;
+            return;
+        }
+
+        default: return;
+    }
+}
+
+// MARK: - Cycles
+
+void SequencerEngine::replay(uint64_t tick) noexcept
+{
+    // The state at the start of the tick equals the state at the start of the recorded tick, so each recorded visit has the same
+    // effects on the nodes, the subsequences, and the lookahead as it had when it was recorded.
+
+    loop.replay(tick, playheads, [this](const Visit & visit, uint16_t offset, bool enabled)
+    {
+        lookahead.setOffset(offset);
+        commit(visit, enabled);
+    });
+
+    playheads.elapse((tick + 1) * EnginePlayhead::TICK_RESOLUTION);
+}
+
+void SequencerEngine::rehash() noexcept
+{
+    nodeHash = 0;
+
+    grid.forEach([this](const EngineNode & node, int x, int y)
+    {
+        if (node.type == Redirect && node.isStateful())
+            nodeHash = nodeHash ^ hashNode({x, y}, node.redirect);
+
+        else if (node.type == Subsequence)
+            nodeHash = nodeHash ^ hashNode(node.subsequence.index);
+    });
+}
+
+uint64_t SequencerEngine::hashState(uint64_t tick) const noexcept
+{
+    const uint64_t time = tick * EnginePlayhead::TICK_RESOLUTION;
+    uint64_t hash = nodeHash;
+
+    for (size_t k = 0; k < playheads.size(); ++k)
+    {
+        const uint64_t position  = static_cast<uint64_t>(static_cast<uint32_t>(playheads.x[k])) << 32
+                                 | static_cast<uint32_t>(playheads.y[k]);
+
+        const uint64_t direction = static_cast<uint64_t>(playheads.dx[k] & 0xFF)
+                                 | static_cast<uint64_t>(playheads.dy[k] & 0xFF) << 8
+                                 | static_cast<uint64_t>(playheads.enabled[k])   << 16;
+
+        const uint64_t timing    = static_cast<uint64_t>(playheads.next[k] - time) << 32 | playheads.interval[k];
+
+        hash = EngineRandom::mix(hash ^ position);
+        hash = EngineRandom::mix(hash ^ direction);
+        hash = EngineRandom::mix(hash ^ timing);
+    }
+
+    return hash;
+}
+
+// MARK: - Snapshots
+
+void SequencerEngine::snapshot(EngineSnapshot& snapshot, const UIPoint<int>& focus) const noexcept
+{
+    snapshot.gridSize    = gridSize;
+    snapshot.revision    = revision;
+    snapshot.tick        = lookahead.getCommittedTick();
+    snapshot.cycleLength = loop.getLength();
+
+    snapshot.nodes.clear();
+    snapshot.positions.clear();
+
+    grid.forEach([this, &snapshot](const EngineNode & node, int x, int y)
+    {
+        if (x >= gridSize.w || y >= gridSize.h) return;
+        if (snapshot.nodes.size() == snapshot.nodes.capacity()) return;
+
+        snapshot.nodes.push_back(node);
+        snapshot.positions.emplace_back(x, y);
+    });
+
+    snapshot.playheads.clear();
+
+    for (size_t k = 0; k < playheads.size(); ++k)
+    {
+        if (snapshot.playheads.size() == snapshot.playheads.capacity()) break;
+
+        snapshot.playheads.push_back(playheads.get(k));
+    }
+
+    lookahead.present(snapshot.playheads);
+
+    const EngineNode* node = getNode(focus);
+
+    snapshot.focus = focus;
+    snapshot.hasFocusNode = node != nullptr;
+
+    if (node != nullptr)
+    {
+        snapshot.focusNode = *node;
+
+        if (node->type == Subsequence)
+            snapshot.focusSubsequence = getSubsequence(*node);
+    }
+}
+
+// MARK: - Edits
+
+void SequencerEngine::apply(const SequencerCommand& command) noexcept
+{
+    invalidate(command);
+
+    try
+    {
+        modify(command);
+    }
+
+    catch (const std::exception &)
+    {
+        // Edits that are no longer valid, e.g., as a result of a resize, are discarded.
+    }
+
+    revision = revision + 1;
+    scheduleIsStale = true;
+
+    // Selecting a playhead is the only edit that doesn't affect the simulation.
+
+    if (command.type != SequencerCommand::SelectPlayhead)
+    {
+        loop.reset();
+        nodeHashIsStale = true;
+    }
+}
+
+void SequencerEngine::invalidate(const SequencerCommand& command) noexcept
+{
+    const UIPoint<int>& xy = command.xy;
+
+    const auto restore = [this](const SequencerLookahead::NodeState & state)
+    {
+        this->restore(state);
+    };
+
+    switch (command.type)
+    {
+        case SequencerCommand::PlaceNote:
+        case SequencerCommand::PlaceNode:
+        {
+            lookahead.invalidate(xy, playheads, restore);
+            return;
+        }
+
+        // A portal's behaviour depends on its pair, so the contents of both cells change when portals are paired or unpaired.
+
+        case SequencerCommand::PlacePortal:
+        {
+            if (!unpairedPortals.empty())
+                lookahead.invalidate(unpairedPortals.back(), playheads, restore);
+
+            lookahead.invalidate(xy, playheads, restore);
+            return;
+        }
+
+        case SequencerCommand::Erase:
+        {
+            const EngineNode* node = getNode(xy);
+
+            if (!command.flag && node != nullptr && node->type == Portal && node->portal.paired)
+                lookahead.invalidate(node->getPairPosition(), playheads, restore);
+
+            lookahead.invalidate(xy, playheads, restore);
+            return;
+        }
+
+        case SequencerCommand::SelectPlayhead:
+            return;
+
+        case SequencerCommand::SetSeed:
+        case SequencerCommand::PlacePlayhead:
+        case SequencerCommand::ErasePlayhead:
+        case SequencerCommand::TogglePlayhead:
+        case SequencerCommand::SetPlayheadRate:
+        case SequencerCommand::CyclePlayheadRate:
+        case SequencerCommand::Resize:
+        {
+            lookahead.invalidate(playheads, restore);
+            return;
+        }
+    }
+}
+
+void SequencerEngine::modify(const SequencerCommand& command) noexcept(false)
+{
+    const UIPoint<int>& xy = command.xy;
+    const bool isOnGrid = xy.x >= 0 && xy.y >= 0 && xy.x < gridSize.w && xy.y < gridSize.h;
+
+    switch (command.type)
+    {
+        case SequencerCommand::PlaceNote:
+        {
+            if (EngineNode* node = find(xy))
+            {
+                if (command.flag && node->type == Subsequence)
+                    subsequences[node->subsequence.index].placeNote(command.index, command.note);
+
+                return;
+            }
+
+            if (command.flag || !isOnGrid || !hasRoomFor(xy)) return;
+
+            const uint16_t subsequence = allocateSubsequence();
+
+            if (subsequence == None) return;
+
+            subsequences[subsequence].placeNote(0, command.note);
+
+            grid.set(EngineNode::makeSubsequence(subsequence), xy.x, xy.y);
+            return;
+        }
+
+        case SequencerCommand::PlaceNode:
+        {
+            if (!isOnGrid || find(xy) != nullptr || !hasRoomFor(xy)) return;
+
+            grid.set(EngineNode::makeRedirect(command.redirection), xy.x, xy.y);
+            return;
+        }
+
+        case SequencerCommand::PlacePortal:
+        {
+            if (!isOnGrid || find(xy) != nullptr || !hasRoomFor(xy)) return;
+
+            EngineNode node = EngineNode::makePortal(PortalType::A);
+            EngineNode* pair = unpairedPortals.empty() ? nullptr : find(unpairedPortals.back());
+
+            if (pair != nullptr)
+            {
+                node.portal.type = pair->getPairPortalType();
+                node.setPairPosition(unpairedPortals.back());
+                pair->setPairPosition(xy);
+                unpairedPortals.pop_back();
+            }
+
+            else
+            {
+                unpairedPortals.push_back(xy);
+            }
+
+            grid.set(node, xy.x, xy.y);
+            return;
+        }
+
+        case SequencerCommand::PlacePlayhead:
+        {
+            if (playheads.isFull()) return;
+
+            EnginePlayhead playhead;
+            playhead.xy    = xy;
+            playhead.delta = command.delta;
+            playhead.setOrigin(lookahead.getSimulatedTick());
+
+            playheads.push(playhead);
+            return;
+        }
+
+        case SequencerCommand::Erase:
+        {
+            erase(command);
+            return;
+        }
+
+        case SequencerCommand::ErasePlayhead:
+        {
+            if (command.index < playheads.size())
+                playheads.erase(command.index);
+
+            return;
+        }
+
+        case SequencerCommand::TogglePlayhead:
+        {
+            if (command.index < playheads.size())
+                playheads.enabled[command.index] = !playheads.enabled[command.index];
+
+            return;
+        }
+
+        case SequencerCommand::SelectPlayhead:
+        {
+            if (command.index < playheads.size())
+                playheads.selected[command.index] = command.flag;
+
+            return;
+        }
+
+        case SequencerCommand::SetPlayheadRate:
+        {
+            if (command.index < playheads.size())
+            {
+                EnginePlayhead playhead = playheads.get(command.index);
+                playhead.setRate(xy.x, xy.y, lookahead.getSimulatedTick());
+                playheads.set(command.index, playhead);
+            }
+
+            return;
+        }
+
+        case SequencerCommand::CyclePlayheadRate:
+        {
+            if (command.index < playheads.size())
+            {
+                EnginePlayhead playhead = playheads.get(command.index);
+                unsigned int multiplier = playhead.multiplier;
+                unsigned int divider    = playhead.divider;
+
+                if (command.flag)
+                     multiplier = multiplier % EnginePlayhead::MAXIMUM_RATE + 1;
+                else divider    = divider    % EnginePlayhead::MAXIMUM_RATE + 1;
+
+                playhead.setRate(multiplier, divider, lookahead.getSimulatedTick());
+                playheads.set(command.index, playhead);
+            }
+
+            return;
+        }
+
+        case SequencerCommand::SetSeed:
+        {
+            random.setSeed(command.seed);
+            return;
+        }
+
+        case SequencerCommand::Resize:
+        {
+            // An invalid size is discarded without throwing, since throwing would allocate on the clock's thread.
+
+            if (xy.x <= 0 || xy.y <= 0 || xy.x > MAXIMUM_GRID_SIZE || xy.y > MAXIMUM_GRID_SIZE)
+            {
+                return;
+            }
+
+            gridSize.set(xy.x, xy.y);
+
+            // Nodes keep their positions when the grid shrinks, so they're restored if it grows again,
+            // but they can't be reached while they're outside the grid. Playheads are wrapped into the grid.
+
+            for (size_t k = 0; k < playheads.size(); ++k)
+            {
+                playheads.x[k] = playheads.x[k] % gridSize.w;
+                playheads.y[k] = playheads.y[k] % gridSize.h;
+            }
+
+            return;
+        }
+    }
+}
+
+void SequencerEngine::erase(const SequencerCommand& command) noexcept(false)
+{
+    const UIPoint<int>& xy = command.xy;
+    EngineNode* node = find(xy);
+
+    if (node == nullptr) return;
+
+    if (command.flag)
+    {
+        if (node->type == Subsequence)
+            subsequences[node->subsequence.index].eraseNote(command.index);
+
+        return;
+    }
+
+    switch (node->type)
+    {
+        case Portal:
+        {
+            if (EngineNode* pair = node->portal.paired ? find(node->getPairPosition()) : nullptr)
+            {
+                pair->portal.paired = false;
+                unpairedPortals.push_back(node->getPairPosition());
+            }
+
+            else
+            {
+                auto &nodes = unpairedPortals;
+                auto remove = std::remove(nodes.begin(), nodes.end(), xy);
+                nodes.erase(remove, nodes.end());
+            }
+
+            break;
+        }
+
+        case Subsequence:
+        {
+            freeSubsequences.push_back(node->subsequence.index);
+            break;
+        }
+
+        default: break;
+    }
+
+    grid.erase(xy.x, xy.y);
+}
+
+uint16_t SequencerEngine::allocateSubsequence() noexcept
+{
+    uint16_t index = None;
+
+    if (!freeSubsequences.empty())
+    {
+        index = freeSubsequences.back();
+        freeSubsequences.pop_back();
+    }
+
+    else if (subsequences.size() < subsequences.capacity())
+    {
+        index = static_cast<uint16_t>(subsequences.size());
+        subsequences.emplace_back();
+    }
+
+    if (index != None)
+    {
+        subsequences[index] = EngineSubsequence();
+    }
+
+    return index;
+}
+
+// MARK: - Projects
+
+void SequencerEngine::rewind() noexcept
+{
+    const auto restore = [this](const SequencerLookahead::NodeState & state)
+    {
+        this->restore(state);
+    };
+
+    lookahead.invalidate(playheads, restore);
+    loop.reset();
+
+    scheduleIsStale = true;
+    nodeHashIsStale = true;
+}
+
+void SequencerEngine::clear(uint64_t position) noexcept
+{
+    grid.clear();
+    playheads.clear();
+    subsequences.clear();
+    freeSubsequences.clear();
+    unpairedPortals.clear();
+
+    lookahead.reset(position);
+    loop.reset();
+
+    scheduleIsStale = true;
+    nodeHashIsStale = true;
+    revision = revision + 1;
+}
@@ -0,0 +1,541 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef SEQUENCERENGINE_HPP
+#define SEQUENCERENGINE_HPP
+
+#include <limits>
+#include <cstdlib>
+#include <numeric>
+#include <array>
+#include <vector>
+#include <thread>
+#include <cstdint>
+#include "UISize.h"
+#include "SparseGrid.h"
+#include "EngineTypes.h"
+#include "EngineRandom.h"
+#include "EnginePlayheads.h"
+#include "EngineWorkers.hpp"
+#include "SequencerCommand.hpp"
+#include "SequencerLoop.hpp"
+#include "SequencerLookahead.hpp"
+
+/// @brief The contents of the Ensemble sequencer and the simulation that moves its playheads, independent of any UI or MIDI device.
+/// @note  Nodes and playheads are plain records stored in contiguous arrays, so a tick touches only the data that determines the music,
+///        and the engine can be linked into tools that have no UI. The engine is owned by one thread at a time, which applies edits,
+///        simulates ticks ahead of the clock, and writes snapshots from which the UI is drawn. When many playheads move at once, their
+///        paths are resolved in parallel by a pool of worker threads and then merged in the order in which the playheads were placed,
+///        so the music is identical regardless of the number of threads. Once the simulation settles into a cycle, one period
+///        of the cycle is recorded and replayed until an edit changes the simulation's behaviour.
+
+class SequencerEngine
+{
+    friend class SequencerProject;
+
+public:
+    /// @brief Construct an empty engine whose playheads' paths are resolved by the pool of threads that's shared by every engine.
+
+    SequencerEngine();
+
+    /// @brief Construct an empty engine.
+    /// @param workers The pool of threads that resolve the paths of the playheads, which must outlive the engine.
+
+    SequencerEngine(EngineWorkers& workers);
+
+    /// @brief Construct a copy of the given engine's state, including its simulated ticks, which shares the given engine's pool of threads.
+    /// @param other The engine to be copied, which must not be modified by another thread during the copy.
+
+    SequencerEngine(const SequencerEngine& other);
+
+    SequencerEngine& operator = (const SequencerEngine&) = delete;
+
+// MARK: - Memory
+
+public:
+    /// @brief Allocate the memory that's used to simulate ticks ahead of the clock and to record cycles, if it has been released.
+    /// @note  An engine's lookahead is reserved when the engine is constructed.
+    /// @throw An exception will be thrown if the memory can't be allocated.
+
+    void reserveLookahead() noexcept(false);
+
+    /// @brief Discard the simulated ticks and the recorded cycle and free the memory that's used to simulate ticks ahead of the clock
+    ///        and to record cycles, e.g., while the engine is a pattern that isn't being played.
+    /// @note  Until the lookahead is reserved again, no tick is simulated, so the engine must not be dispatched or sought.
+
+    void releaseLookahead() noexcept;
+
+// MARK: - Edits
+
+public:
+    /// @brief Discard each of the simulated ticks that would be affected by the given edit and apply the edit.
+    /// @param command The edit to be applied.
+    /// @note  Edits that are no longer valid, e.g., as a result of a resize, are discarded.
+
+    void apply(const SequencerCommand& command) noexcept;
+
+// MARK: - Simulation
+
+public:
+    /// @brief Simulate ticks until the given number of ticks have been simulated ahead of the clock or the lookahead is full.
+    /// @param ticks The desired number of simulated ticks.
+
+    void simulate(size_t ticks) noexcept;
+
+    /// @brief Pass each note scheduled by the earliest simulated tick to the given callable and discard the tick.
+    /// @param broadcast A callable object that accepts each scheduled MIDI note and its offset within the tick
+    ///        in units of `1 / EnginePlayhead::TICK_RESOLUTION` ticks.
+    /// @note  At least one tick must have been simulated.
+
+    template <typename Callback>
+    inline void dispatch(Callback && broadcast) noexcept
+    {
+        lookahead.dispatch(broadcast);
+    }
+
+    /// @brief Advance every playhead by up to the given number of ticks without simulating each move, as long as no playhead
+    ///        would land on a node, e.g., to fast-forward over the silent stretches of an offline render.
+    /// @param ticks The greatest number of ticks to be skipped.
+    /// @return The number of ticks that were skipped, which is zero if a playhead would land on a node during the next tick.
+    /// @note  Nothing is skipped unless every simulated tick has been dispatched.
+
+    uint64_t skip(uint64_t ticks) noexcept;
+
+    /// @brief Advance the engine by the given number of ticks from its earliest undispatched tick without dispatching any notes,
+    ///        e.g., to line the engine up with a position on another sequencer's timeline.
+    /// @param ticks The number of ticks to be advanced.
+    /// @note  Simulated ticks are discarded, stretches of silence are skipped, and once a cycle has been found, each whole period
+    ///        of the cycle is passed over without being simulated, so seeking far ahead of a repeating pattern is near-instant.
+
+    void seek(uint64_t ticks) noexcept;
+
+    /// @brief Return the absolute index of the engine's earliest undispatched tick, which is the number of ticks that have been
+    ///        dispatched, skipped, or sought past since the engine was created.
+
+    inline uint64_t getPosition() const noexcept
+    {
+        return lookahead.getCommittedTick();
+    }
+
+    /// @brief Return the number of ticks that have been simulated but not yet dispatched.
+
+    inline size_t getNumberOfSimulatedTicks() const noexcept
+    {
+        return lookahead.size();
+    }
+
+    /// @brief Return the number of ticks after which the simulation repeats itself exactly, or zero if no cycle has been found
+    ///        since the most recent edit.
+
+    inline uint64_t getCycleLength() const noexcept
+    {
+        return loop.getLength();
+    }
+
+// MARK: - Snapshots
+
+public:
+    /// @brief Copy the engine's state into the given snapshot.
+    /// @param snapshot The snapshot to be written, whose storage must have been reserved for the engine's capacity.
+    /// @param focus The position of the cell whose contents should be described in full.
+
+    void snapshot(EngineSnapshot& snapshot, const UIPoint<int>& focus) const noexcept;
+
+// MARK: - State
+
+public:
+    /// @brief Return the dimensions of the grid in rows and columns.
+
+    inline const UISize<int>& getGridSize() const noexcept
+    {
+        return gridSize;
+    }
+
+    /// @brief Return the node at the given position, or nullptr if the position is empty or out of range.
+    /// @param xy The position of the cell.
+
+    inline const EngineNode* getNode(const UIPoint<int>& xy) const noexcept
+    {
+        if (xy.x < 0 || xy.y < 0 || xy.x >= gridSize.w || xy.y >= gridSize.h)
+            return nullptr;
+
+        return grid.get(xy.x, xy.y);
+    }
+
+    /// @brief Return the notes of the given subsequence node.
+    /// @param node A node whose type is `Subsequence`.
+
+    inline const EngineSubsequence& getSubsequence(const EngineNode& node) const noexcept
+    {
+        return subsequences[node.subsequence.index];
+    }
+
+    /// @brief Return the engine's playheads in the order in which they were placed.
+
+    inline const EnginePlayheads& getPlayheads() const noexcept
+    {
+        return playheads;
+    }
+
+    /// @brief Return the seed from which the choices of Random redirects are derived.
+
+    inline uint64_t getSeed() const noexcept
+    {
+        return random.getSeed();
+    }
+
+    /// @brief Return the number of edits that have been applied to the engine.
+
+    inline uint64_t getRevision() const noexcept
+    {
+        return revision;
+    }
+
+private:
+    /// @brief Return the node at the given position, or nullptr if the position is empty or out of range.
+
+    inline EngineNode* find(const UIPoint<int>& xy) noexcept
+    {
+        if (xy.x < 0 || xy.y < 0 || xy.x >= gridSize.w || xy.y >= gridSize.h)
+            return nullptr;
+
+        return grid.get(xy.x, xy.y);
+    }
+
+    /// @brief Indicate whether a node can be placed at the given position without exceeding the engine's capacity.
+
+    inline bool hasRoomFor(const UIPoint<int>& xy) const noexcept
+    {
+        return grid.size() < MAXIMUM_NODES && grid.hasRoomFor(xy.x, xy.y);
+    }
+
+// MARK: - Simulation
+
+private:
+    /// @brief Simulate the next tick and record the notes it should broadcast.
+    /// @note  The playheads that are due to move at the same time are advanced together.
+
+    void simulate() noexcept;
+
+    /// @brief A cell that a playhead visited during a move and the state of its node at the time of the visit.
+
+    struct Visit
+    {
+        UIPoint<int> xy;
+        EngineNode node;
+
+        /// @brief Whether the cell held a node.
+
+        bool occupied   = false;
+
+        /// @brief Whether the node was a redirect that changed the playhead's direction.
+
+        bool redirected = false;
+    };
+
+    /// @brief The outcome of a playhead's move, which is resolved without modifying the engine's state.
+
+    struct Path
+    {
+        UIPoint<int> xy;
+        UIPoint<int> delta;
+
+        /// @brief Whether the path visited an Alternating or Random redirect more than once, in which case the path depends on
+        ///        changes to the redirect's state that were made during the move itself.
+
+        bool isSelfDependent = false;
+
+        size_t numberOfVisits = 0;
+        std::array<Visit, SequencerLookahead::MAXIMUM_INTERACTIONS_PER_MOVE> visits;
+    };
+
+    /// @brief Interact with the nodes that the given playhead lands on after it has been advanced by one step.
+    /// @param index The index of the playhead that has been advanced.
+
+    void move(size_t index) noexcept;
+
+    /// @brief Resolve the path of the given playhead's move from the current state of the grid without modifying the engine's state.
+    /// @param index The index of the playhead that has been advanced.
+    /// @param path The path to be written.
+    /// @note  This can be called from several threads at once.
+
+    void resolve(size_t index, Path& path) const noexcept;
+
+    /// @brief Apply the given playhead's resolved path, or move the playhead again if the path is no longer valid.
+    /// @param index The index of the playhead whose path was resolved.
+    /// @param path The path that was resolved before any of the moves that precede it were applied.
+    /// @note  A path is valid if each Alternating or Random redirect it visited is still in the state it had when the path was
+    ///        resolved, since no other node changes direction during a tick. Applying the paths in order is therefore equivalent
+    ///        to moving each playhead in order.
+
+    void merge(size_t index, const Path& path) noexcept;
+
+    /// @brief Interact with each cell that a playhead lands on during a move, in the order in which a move proceeds.
+    /// @param xy The position of the playhead that has been advanced.
+    /// @param delta The direction of the playhead that has been advanced.
+    /// @param interact A callable object that interacts with the cell at the given position and direction and returns a Boolean
+    ///        value to indicate whether the playhead's move is complete.
+
+    template <typename Interact>
+    inline void walk(UIPoint<int>& xy, UIPoint<int>& delta, Interact && interact) const noexcept
+    {
+        const UIPoint<int> originalPosition = {(xy.x - delta.x + gridSize.w) % gridSize.w,
+                                               (xy.y - delta.y + gridSize.h) % gridSize.h};
+
+        if (interact(xy, delta))
+        {
+            return;
+        }
+
+        if (xy == originalPosition)
+        {
+            step(xy, delta);
+        }
+
+        for (size_t k = 0; k < SequencerLookahead::MAXIMUM_INTERACTIONS_PER_MOVE - 1; ++k)
+        {
+            if (interact(xy, delta)) break;
+        }
+    }
+
+    /// @brief Interact with the node at the given position, if any.
+    /// @param xy The position of the playhead that's interacting with the node.
+    /// @param delta The direction of the playhead that's interacting with the node.
+    /// @param enabled Whether the playhead broadcasts the notes it lands on or not.
+    /// @return A Boolean value to indicate whether the playhead's move is complete.
+
+    bool interact(UIPoint<int>& xy, UIPoint<int>& delta, bool enabled) noexcept;
+
+    /// @brief Move a playhead past the given node without modifying the engine's state.
+    /// @param node The node at the playhead's position, or nullptr if the cell is empty.
+    /// @param xy The position of the playhead.
+    /// @param delta The direction of the playhead.
+    /// @param visit The visit to be recorded.
+    /// @return A Boolean value to indicate whether the playhead's move is complete.
+
+    bool trace(const EngineNode* node, UIPoint<int>& xy, UIPoint<int>& delta, Visit& visit) const noexcept;
+
+    /// @brief Record the given visit in the lookahead and apply its effects on the visited node.
+    /// @param visit The visit.
+    /// @param enabled Whether the visiting playhead broadcasts the notes it lands on or not.
+
+    void commit(const Visit& visit, bool enabled) noexcept;
+
+    /// @brief Redirect a playhead based on its direction and move it past the redirect.
+    /// @param node The redirect.
+    /// @param xy The position of the playhead to be redirected.
+    /// @param delta The direction of the playhead to be redirected.
+    /// @return A Boolean value to indicate whether the playhead was redirected.
+
+    bool redirect(const EngineNode& node, UIPoint<int>& xy, UIPoint<int>& delta) const noexcept;
+
+    /// @brief Update the state of an Alternating or Random redirect after it has redirected a playhead.
+    /// @param node The redirect.
+    /// @param xy The position of the redirect.
+
+    void cycle(EngineNode& node, const UIPoint<int>& xy) noexcept;
+
+    /// @brief Teleport a playhead to the portal's pair, or to the opposite edge of the grid if the portal is unpaired.
+    /// @param node The portal.
+    /// @param xy The position of the playhead that's passing through the portal.
+    /// @param delta The direction of the playhead that's passing through the portal.
+
+    void teleport(const EngineNode& node, UIPoint<int>& xy, const UIPoint<int>& delta) const noexcept;
+
+    /// @brief Schedule the subsequence's current note to be broadcast and move to its next note.
+    /// @param node The subsequence.
+    /// @param enabled Whether the playhead that's interacting with the subsequence broadcasts notes or not.
+
+    void play(const EngineNode& node, bool enabled) noexcept;
+
+    /// @brief Move the given position by the given direction, wrapping around the edges of the grid.
+
+    inline void step(UIPoint<int>& xy, const UIPoint<int>& delta) const noexcept
+    {
+        xy.x = (xy.x + delta.x + gridSize.w) % gridSize.w;
+        xy.y = (xy.y + delta.y + gridSize.h) % gridSize.h;
+    }
+
+    /// @brief Compute the number of moves before the given playhead next lands on a node.
+    /// @param playhead The playhead.
+    /// @param limit The greatest number of moves to be searched.
+    /// @return The number of moves, or zero if the playhead doesn't land on a node within the given number of moves.
+    /// @note  Each stretch of the playhead's path between the edges of the grid is searched with the grid's occupancy bitmaps.
+
+    uint64_t getDistanceToNextNode(const EnginePlayhead& playhead, uint64_t limit) const noexcept;
+
+    /// @brief Restore a stateful node to the state it had before a simulated tick that's being discarded.
+    /// @param state The recorded state of the node.
+
+    void restore(const SequencerLookahead::NodeState& state) noexcept;
+
+// MARK: - Cycles
+
+private:
+    /// @brief Simulate the given tick by replaying the corresponding tick of the recorded cycle.
+    /// @param tick The absolute index of the tick being simulated.
+
+    void replay(uint64_t tick) noexcept;
+
+    /// @brief Recompute the combined hash of every stateful node's state.
+
+    void rehash() noexcept;
+
+    /// @brief Compute the hash of the engine's dynamic state at the start of the given tick, i.e., the position, direction, and
+    ///        timing of each playhead, and the state of each stateful node.
+    /// @param tick The absolute index of the tick, which must not precede any playhead's next move.
+    /// @note  A playhead's timing is hashed relative to the start of the tick, so states at different times can be equal.
+
+    uint64_t hashState(uint64_t tick) const noexcept;
+
+    /// @brief Compute the hash of an Alternating or Random redirect's state.
+    /// @param xy The position of the redirect.
+    /// @param redirect The state of the redirect.
+
+    inline static uint64_t hashNode(const UIPoint<int>& xy, const RedirectState& redirect) noexcept
+    {
+        const uint64_t key   = static_cast<uint64_t>(static_cast<uint32_t>(xy.x)) << 32 | static_cast<uint32_t>(xy.y);
+        const uint64_t state = redirect.state | redirect.choice << 8 | static_cast<uint64_t>(redirect.counter) << 16;
+
+        return EngineRandom::mix(key ^ EngineRandom::mix(state + 1));
+    }
+
+    /// @brief Compute the hash of a subsequence's state.
+    /// @param index The index of the subsequence in the pool of subsequences.
+
+    inline uint64_t hashNode(uint16_t index) const noexcept
+    {
+        const uint64_t key   = 1ull << 63 | index;
+        const uint64_t state = subsequences[index].index;
+
+        return EngineRandom::mix(key ^ EngineRandom::mix(state + 1));
+    }
+
+// MARK: - Edits
+
+private:
+    /// @brief Discard each of the simulated ticks that would be affected by the given edit.
+    /// @param command The edit that's about to be applied.
+
+    void invalidate(const SequencerCommand& command) noexcept;
+
+    /// @brief Apply the given edit to the engine's state.
+    /// @param command The edit to be applied.
+
+    void modify(const SequencerCommand& command) noexcept(false);
+
+    /// @brief Apply an edit that erases the contents of the grid at the given position.
+    /// @param command The edit to be applied.
+
+    void erase(const SequencerCommand& command) noexcept(false);
+
+    /// @brief Take an unused subsequence from the pool of subsequences and clear it.
+    /// @return The index of the subsequence, or `None` if the pool is exhausted.
+
+    uint16_t allocateSubsequence() noexcept;
+
+// MARK: - Projects
+
+private:
+    /// @brief Discard every simulated tick, so the engine's state matches its earliest undispatched tick, e.g., before it's saved.
+
+    void rewind() noexcept;
+
+    /// @brief Remove every node, playhead, and subsequence and move the engine to the given tick without releasing any storage,
+    ///        e.g., before the contents of a saved project are loaded.
+    /// @param position The absolute index of the next tick to be simulated and dispatched.
+
+    void clear(uint64_t position) noexcept;
+
+public:
+    /// @brief The greatest number of nodes that the grid can hold.
+
+    constexpr static size_t MAXIMUM_NODES = 65536;
+
+    /// @brief The greatest number of tiles of the grid that can be occupied by nodes at once.
+
+    constexpr static size_t MAXIMUM_TILES = 1024;
+
+    /// @brief The greatest number of rows or columns of the grid.
+
+    constexpr static int MAXIMUM_GRID_SIZE = SparseGrid<EngineNode>::MAXIMUM_COORDINATE + 1;
+
+    /// @brief The greatest number of playheads.
+
+    constexpr static size_t MAXIMUM_PLAYHEADS = SequencerLookahead::MAXIMUM_PLAYHEADS;
+
+    /// @brief The greatest number of subsequences.
+
+    constexpr static size_t MAXIMUM_SUBSEQUENCES = 4096;
+
+    /// @brief The least number of playheads moving at once whose paths are resolved in parallel.
+
+    constexpr static size_t PARALLEL_THRESHOLD = 256;
+
+private:
+    constexpr static uint16_t None = std::numeric_limits<uint16_t>::max();
+
+private:
+    /// @brief The nodes on the grid, which keep their positions when the grid is resized.
+
+    SparseGrid<EngineNode> grid;
+
+    EnginePlayheads playheads;
+
+    /// @brief The notes of each subsequence node, which are stored apart from the grid since they're only read on interaction.
+
+    std::vector<EngineSubsequence> subsequences;
+
+    /// @brief The indices of the subsequences that are not in use.
+
+    std::vector<uint16_t> freeSubsequences;
+
+    /// @brief The positions of the portals that are waiting to be paired, in the order in which they were placed.
+
+    std::vector<UIPoint<int>> unpairedPortals;
+
+    UISize<int> gridSize = {4, 4};
+
+private:
+    /// @brief The ticks that have been simulated ahead of the clock.
+
+    SequencerLookahead lookahead;
+
+    /// @brief The indices of the playheads that moved during the current step of the simulation.
+
+    std::vector<uint32_t> moving;
+
+    /// @brief The resolved path of each of the playheads that moved during the current step of the simulation.
+
+    std::vector<Path> paths;
+
+    /// @brief The threads that resolve the paths of the playheads, which may be shared with other engines.
+
+    EngineWorkers& workers;
+
+    /// @brief Whether edits have added, removed, or rewound playheads since the time of each playhead's next move was computed.
+
+    bool scheduleIsStale = false;
+
+    /// @brief The detector of cycles in the simulation and the recording of the most recent cycle.
+
+    SequencerLoop<Visit> loop;
+
+    /// @brief The combined hash of every stateful node's state, which is the exclusive or of each node's hash.
+
+    uint64_t nodeHash = 0;
+
+    /// @brief Whether edits have modified or rewound any node since the combined hash of the nodes' states was computed.
+
+    bool nodeHashIsStale = true;
+
+    /// @brief The number of edits that have been applied.
+
+    uint64_t revision = 0;
+
+    /// @brief The source of the choices made by Random redirects, which is seeded by a `SetSeed` command.
+
+    EngineRandom random;
+};
+
+#endif
@@ -0,0 +1,114 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#include "SequencerLookahead.hpp"
+
+static_assert(EnginePlayhead::MAXIMUM_RATE <= SequencerLookahead::MAXIMUM_MOVES_PER_PLAYHEAD,
+              "Every move a playhead can make during one tick must be recorded.");
+
+void SequencerLookahead::allocate() noexcept(false)
+{
+    if (isAllocated())
+    {
+        return;
+    }
+
+    frames.resize(MAXIMUM_LOOKAHEAD);
+    nodes.resize(MAXIMUM_JOURNALED_NODES);
+    notes.resize(MAXIMUM_JOURNALED_NOTES);
+}
+
+void SequencerLookahead::deallocate() noexcept
+{
+    std::vector<Frame>().swap(frames);
+    std::vector<NodeState>().swap(nodes);
+    std::vector<ScheduledNote>().swap(notes);
+}
+
+// MARK: - Simulation
+
+void SequencerLookahead::begin(const EnginePlayheads& playheads) noexcept
+{
+    Frame & frame = at(simulated);
+
+    frame.numberOfPlayheads = std::min(playheads.size(), MAXIMUM_PLAYHEADS);
+    frame.firstNode = nodeHead;
+    frame.firstNote = noteHead;
+    frame.numberOfNodes = 0;
+    frame.numberOfNotes = 0;
+    frame.visits.reset();
+    offset = 0;
+
+    const size_t count = frame.numberOfPlayheads;
+
+    std::copy_n(playheads.x.begin(), count, frame.x.begin());
+    std::copy_n(playheads.y.begin(), count, frame.y.begin());
+    std::copy_n(playheads.dx.begin(), count, frame.dx.begin());
+    std::copy_n(playheads.dy.begin(), count, frame.dy.begin());
+    std::copy_n(playheads.moves.begin(), count, frame.moves.begin());
+}
+
+void SequencerLookahead::visit(const UIPoint<int>& xy) noexcept
+{
+    at(simulated).visits.set(key(xy));
+}
+
+void SequencerLookahead::record(const NodeState& state) noexcept
+{
+    if (nodeHead - nodeTail() < MAXIMUM_JOURNALED_NODES)
+    {
+        nodes[nodeHead % MAXIMUM_JOURNALED_NODES] = state;
+        nodeHead = nodeHead + 1;
+        at(simulated).numberOfNodes++;
+    }
+}
+
+void SequencerLookahead::broadcast(const MIDINote& note) noexcept
+{
+    if (noteHead - noteTail() < MAXIMUM_JOURNALED_NOTES)
+    {
+        notes[noteHead % MAXIMUM_JOURNALED_NOTES] = {note, offset};
+        noteHead = noteHead + 1;
+        at(simulated).numberOfNotes++;
+    }
+}
+
+void SequencerLookahead::end() noexcept
+{
+    simulated = simulated + 1;
+}
+
+void SequencerLookahead::skip(uint64_t ticks) noexcept
+{
+    if (!isEmpty())
+    {
+        return;
+    }
+
+    simulated = simulated + ticks;
+    committed = simulated;
+}
+
+void SequencerLookahead::reset(uint64_t tick) noexcept
+{
+    simulated = tick;
+    committed = tick;
+}
+
+// MARK: - Dispatch
+
+void SequencerLookahead::present(std::vector<EnginePlayhead>& playheads) const noexcept
+{
+    if (isEmpty())
+    {
+        return;
+    }
+
+    const Frame & frame = at(committed);
+    const size_t count  = std::min(frame.numberOfPlayheads, playheads.size());
+
+    for (size_t k = 0; k < count; ++k)
+    {
+        playheads[k].xy.set(frame.x[k], frame.y[k]);
+    }
+}
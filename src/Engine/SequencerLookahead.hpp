@@ -0,0 +1,410 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef SEQUENCERLOOKAHEAD_HPP
+#define SEQUENCERLOOKAHEAD_HPP
+
+#include <array>
+#include <bitset>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "UIPoint.h"
+#include "MIDINote.h"
+#include "EnginePlayhead.h"
+#include "EnginePlayheads.h"
+
+/// @brief A ring of ticks that have been simulated ahead of the clock, each holding the notes it should broadcast when it's dispatched.
+/// @note  Before each tick is simulated, the state of every playhead is recorded, and before a playhead interacts with a stateful node,
+///        such as a subsequence or an alternating redirect, the node's state is recorded, so the simulation can be rewound to any tick
+///        in the ring. The cells visited during each tick are also recorded, so an edit only invalidates the ticks from the first tick
+///        that visited the edited cell onwards. Each note is scheduled at an offset within its tick, because playheads can move at
+///        fractions of a tick. The states of nodes and the scheduled notes of every tick share two journals, so the number of
+///        ticks that can be simulated ahead adapts to the number of playheads. The ring is owned by the thread that owns the
+///        sequencer engine. The frames and journals are allocated on demand, so an engine that isn't being played doesn't hold them.
+
+class SequencerLookahead
+{
+public:
+    /// @brief Allocate the ring's frames and journals if they haven't been allocated yet.
+    /// @throw An exception will be thrown if the memory can't be allocated.
+
+    void allocate() noexcept(false);
+
+    /// @brief Free the ring's frames and journals. No tick can be simulated until the ring is allocated again.
+    /// @note  Every simulated tick must have been discarded.
+
+    void deallocate() noexcept;
+
+    /// @brief Indicate whether the ring's frames and journals have been allocated.
+
+    inline bool isAllocated() const noexcept
+    {
+        return !frames.empty();
+    }
+
+public:
+    /// @brief The state of a stateful node before a playhead interacted with it.
+    /// @note  Nodes are identified by position rather than by address, because erasing a node can move other nodes in memory.
+
+    struct NodeState
+    {
+        UIPoint<int> xy;
+
+        /// @brief The index of the current note of a subsequence.
+
+        uint8_t index  = 0;
+
+        /// @brief The state of an Alternating redirect.
+
+        bool    state  = false;
+
+        /// @brief The choice of a Random redirect.
+
+        uint8_t choice = 0;
+
+        /// @brief The number of choices a Random redirect has made.
+
+        uint16_t counter = 0;
+    };
+
+public:
+    /// @brief Return the number of ticks that have been simulated but not yet dispatched.
+
+    inline size_t size() const noexcept
+    {
+        return static_cast<size_t>(simulated - committed);
+    }
+
+    /// @brief Indicate whether every simulated tick has been dispatched.
+
+    inline bool isEmpty() const noexcept
+    {
+        return simulated == committed;
+    }
+
+    /// @brief Indicate whether the ring has no room to simulate another tick, which is the case while the ring isn't allocated.
+
+    inline bool isFull() const noexcept
+    {
+        return !isAllocated() || size() >= MAXIMUM_LOOKAHEAD;
+    }
+
+    /// @brief Indicate whether the ring has room to simulate another tick of the given number of playheads.
+    /// @param playheads The number of playheads.
+    /// @note  The journals must have room for the greatest number of interactions that the playheads could make during one tick.
+    ///        There's always room for one tick of the greatest number of playheads when every simulated tick has been dispatched.
+
+    inline bool hasRoomFor(size_t playheads) const noexcept
+    {
+        const size_t moves = std::min(playheads, MAXIMUM_PLAYHEADS) * MAXIMUM_MOVES_PER_PLAYHEAD;
+
+        return !isFull()
+            && MAXIMUM_JOURNALED_NODES - (nodeHead - nodeTail()) >= moves * MAXIMUM_INTERACTIONS_PER_MOVE
+            && MAXIMUM_JOURNALED_NOTES - (noteHead - noteTail()) >= moves;
+    }
+
+// MARK: - Simulation
+
+public:
+    /// @brief Begin simulating the next tick by recording the state of each playhead.
+    /// @param playheads The sequencer's playheads.
+    /// @note  The ring must not be full.
+
+    void begin(const EnginePlayheads& playheads) noexcept;
+
+    /// @brief Record that a playhead visited the given cell during the tick being simulated.
+    /// @param xy The position of the visited cell.
+
+    void visit(const UIPoint<int>& xy) noexcept;
+
+    /// @brief Record the state of a stateful node before a playhead interacts with it during the tick being simulated.
+    /// @param state The state of the node that's about to be interacted with.
+
+    void record(const NodeState& state) noexcept;
+
+    /// @brief Set the offset within the tick being simulated of the notes that are subsequently scheduled.
+    /// @param offset The offset in units of `1 / EnginePlayhead::TICK_RESOLUTION` ticks.
+
+    inline void setOffset(uint16_t offset) noexcept
+    {
+        this->offset = offset;
+    }
+
+    /// @brief Return the offset within the tick being simulated of the notes being scheduled.
+
+    inline uint16_t getOffset() const noexcept
+    {
+        return offset;
+    }
+
+    /// @brief Return the absolute index of the tick being simulated, or of the next tick to be simulated.
+
+    inline uint64_t getSimulatedTick() const noexcept
+    {
+        return simulated;
+    }
+
+    /// @brief Schedule the given note to be broadcast when the tick being simulated is dispatched.
+    /// @param note The MIDI note to be broadcast.
+
+    void broadcast(const MIDINote& note) noexcept;
+
+    /// @brief Finish simulating the current tick.
+
+    void end() noexcept;
+
+    /// @brief Advance the simulation by the given number of ticks, during which no playhead visits a node.
+    /// @param ticks The number of ticks to be skipped.
+    /// @note  Every simulated tick must have been dispatched. The skipped ticks are treated as dispatched.
+
+    void skip(uint64_t ticks) noexcept;
+
+    /// @brief Discard every simulated tick without restoring any state and move the simulation to the given tick,
+    ///        e.g., when the state of the engine is replaced by a saved project.
+    /// @param tick The absolute index of the next tick to be simulated and dispatched.
+
+    void reset(uint64_t tick) noexcept;
+
+// MARK: - Dispatch
+
+public:
+    /// @brief Pass each note scheduled by the earliest simulated tick to the given callable and discard the tick.
+    /// @param broadcast A callable object that accepts each scheduled MIDI note and its offset within the tick.
+    /// @note  The ring must not be empty.
+
+    template <typename Callback>
+    void dispatch(Callback && broadcast) noexcept
+    {
+        const Frame & frame = at(committed);
+
+        for (size_t k = 0; k < frame.numberOfNotes; ++k)
+        {
+            const ScheduledNote & note = notes[(frame.firstNote + k) % MAXIMUM_JOURNALED_NOTES];
+            broadcast(note.note, note.offset);
+        }
+
+        committed = committed + 1;
+    }
+
+    /// @brief Move each of the given copies of the sequencer's playheads to its position after the most recently dispatched tick.
+    /// @param playheads Copies of the sequencer's playheads, in order.
+    /// @note  The playheads are simulated ahead of the clock, so their positions can be ahead of the positions that are being heard.
+
+    void present(std::vector<EnginePlayhead>& playheads) const noexcept;
+
+    /// @brief Return the absolute index of the next tick to be dispatched.
+
+    inline uint64_t getCommittedTick() const noexcept
+    {
+        return committed;
+    }
+
+// MARK: - Invalidation
+
+public:
+    /// @brief Rewind the simulation to the first undispatched tick that visited the given cell.
+    /// @param xy The position of the cell whose contents are about to change.
+    /// @param playheads The sequencer's playheads.
+    /// @param restore A callable object that accepts the recorded state of each node that should be restored.
+
+    template <typename Restore>
+    void invalidate(const UIPoint<int>& xy, EnginePlayheads& playheads, Restore && restore) noexcept
+    {
+        const size_t cell = key(xy);
+
+        for (uint64_t tick = committed; tick < simulated; ++tick)
+        {
+            if (at(tick).visits.test(cell))
+            {
+                return rewind(tick, playheads, restore);
+            }
+        }
+    }
+
+    /// @brief Rewind the simulation to the first undispatched tick.
+    /// @param playheads The sequencer's playheads.
+    /// @param restore A callable object that accepts the recorded state of each node that should be restored.
+
+    template <typename Restore>
+    void invalidate(EnginePlayheads& playheads, Restore && restore) noexcept
+    {
+        rewind(committed, playheads, restore);
+    }
+
+private:
+    /// @brief Restore the state of the simulation before the given tick was simulated and discard every tick from the given tick onwards.
+    /// @param tick The absolute index of the earliest tick to be discarded.
+    /// @param playheads The sequencer's playheads.
+    /// @param restore A callable object that accepts the recorded state of each node that should be restored.
+
+    template <typename Restore>
+    void rewind(uint64_t tick, EnginePlayheads& playheads, Restore && restore) noexcept
+    {
+        if (tick >= simulated)
+        {
+            return;
+        }
+
+        // The journal of each tick is undone in reverse order, so each node is left in the state it had before the given tick.
+
+        for (uint64_t t = simulated; t > tick; --t)
+        {
+            const Frame & frame = at(t - 1);
+
+            for (size_t k = frame.numberOfNodes; k > 0; --k)
+            {
+                restore(nodes[(frame.firstNode + k - 1) % MAXIMUM_JOURNALED_NODES]);
+            }
+        }
+
+        const Frame & frame = at(tick);
+        const size_t count  = std::min(frame.numberOfPlayheads, playheads.size());
+
+        std::copy_n(frame.x.begin(), count, playheads.x.begin());
+        std::copy_n(frame.y.begin(), count, playheads.y.begin());
+        std::copy_n(frame.dx.begin(), count, playheads.dx.begin());
+        std::copy_n(frame.dy.begin(), count, playheads.dy.begin());
+        std::copy_n(frame.moves.begin(), count, playheads.moves.begin());
+
+        simulated = tick;
+        nodeHead  = frame.firstNode;
+        noteHead  = frame.firstNote;
+    }
+
+    /// @brief Compute the bit that represents the cell at the given position in a tick's set of visited cells.
+    /// @note  Distinct cells can share a bit, which can only cause more ticks to be re-simulated than necessary.
+
+    inline static size_t key(const UIPoint<int>& xy) noexcept
+    {
+        const uint32_t x = static_cast<uint32_t>(xy.x) * 0x9E3779B1u;
+        const uint32_t y = static_cast<uint32_t>(xy.y) * 0x85EBCA77u;
+
+        return ((x ^ y) >> 20) & (MAXIMUM_CELLS - 1);
+    }
+
+public:
+    /// @brief The maximum number of ticks that can be simulated ahead of the clock.
+
+    constexpr static size_t MAXIMUM_LOOKAHEAD = 16;
+
+    /// @brief The maximum number of playheads whose state can be recorded.
+
+    constexpr static size_t MAXIMUM_PLAYHEADS = 4096;
+
+    /// @brief The maximum number of times a playhead can move during one tick.
+
+    constexpr static size_t MAXIMUM_MOVES_PER_PLAYHEAD = 8;
+
+    /// @brief The maximum number of nodes a playhead can interact with during one move.
+
+    constexpr static size_t MAXIMUM_INTERACTIONS_PER_MOVE = 5;
+
+private:
+    /// @brief The maximum number of playhead moves during one tick.
+
+    constexpr static size_t MAXIMUM_MOVES = MAXIMUM_PLAYHEADS * MAXIMUM_MOVES_PER_PLAYHEAD;
+
+    /// @brief The number of bits in a tick's set of visited cells.
+
+    constexpr static size_t MAXIMUM_CELLS = 65536;
+
+    /// @brief The number of node states that can be recorded across every simulated tick.
+
+    constexpr static size_t MAXIMUM_JOURNALED_NODES = 2 * MAXIMUM_MOVES * MAXIMUM_INTERACTIONS_PER_MOVE;
+
+    /// @brief The number of notes that can be scheduled across every simulated tick.
+
+    constexpr static size_t MAXIMUM_JOURNALED_NOTES = 2 * MAXIMUM_MOVES;
+
+    /// @brief A note and its offset within its tick.
+
+    struct ScheduledNote
+    {
+        MIDINote note;
+        uint16_t offset;
+    };
+
+    /// @brief A simulated tick, which holds the state of each playhead before the tick and refers to its entries in the journals.
+
+    struct Frame
+    {
+        std::array<int32_t,  MAXIMUM_PLAYHEADS> x;
+        std::array<int32_t,  MAXIMUM_PLAYHEADS> y;
+        std::array<int32_t,  MAXIMUM_PLAYHEADS> dx;
+        std::array<int32_t,  MAXIMUM_PLAYHEADS> dy;
+        std::array<uint64_t, MAXIMUM_PLAYHEADS> moves;
+        std::bitset<MAXIMUM_CELLS> visits;
+
+        size_t numberOfPlayheads = 0;
+
+        /// @brief The absolute index of the tick's first entry in the journal of node states.
+
+        uint64_t firstNode = 0;
+        size_t numberOfNodes = 0;
+
+        /// @brief The absolute index of the tick's first entry in the journal of scheduled notes.
+
+        uint64_t firstNote = 0;
+        size_t numberOfNotes = 0;
+    };
+
+    /// @brief Return the frame of the given absolute tick.
+
+    inline Frame & at(uint64_t tick) noexcept
+    {
+        return frames[tick % MAXIMUM_LOOKAHEAD];
+    }
+
+    inline const Frame & at(uint64_t tick) const noexcept
+    {
+        return frames[tick % MAXIMUM_LOOKAHEAD];
+    }
+
+    /// @brief Return the absolute index of the oldest entry in the journal of node states that's still in use.
+
+    inline uint64_t nodeTail() const noexcept
+    {
+        return isEmpty() ? nodeHead : at(committed).firstNode;
+    }
+
+    /// @brief Return the absolute index of the oldest entry in the journal of scheduled notes that's still in use.
+
+    inline uint64_t noteTail() const noexcept
+    {
+        return isEmpty() ? noteHead : at(committed).firstNote;
+    }
+
+private:
+    std::vector<Frame> frames;
+
+    /// @brief The state of each node before a playhead interacted with it, in the order of the interactions.
+
+    std::vector<NodeState> nodes;
+
+    /// @brief The notes scheduled by each tick, in order.
+
+    std::vector<ScheduledNote> notes;
+
+    /// @brief The absolute index of the next entry to be written to the journal of node states.
+
+    uint64_t nodeHead = 0;
+
+    /// @brief The absolute index of the next entry to be written to the journal of scheduled notes.
+
+    uint64_t noteHead = 0;
+
+    /// @brief The absolute index of the next tick to be dispatched.
+
+    uint64_t committed = 0;
+
+    /// @brief The absolute index of the next tick to be simulated.
+
+    uint64_t simulated = 0;
+
+    /// @brief The offset within the tick being simulated of the notes being scheduled.
+
+    uint16_t offset = 0;
+};
+
+#endif
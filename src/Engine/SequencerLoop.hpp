@@ -0,0 +1,291 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef SEQUENCERLOOP_HPP
+#define SEQUENCERLOOP_HPP
+
+#include <vector>
+#include <cstdint>
+#include "EnginePlayheads.h"
+
+/// @brief A detector of cycles in the sequencer engine's simulation and a recording of one period of a cycle, which can be replayed.
+/// @note  Between edits, the simulation is a deterministic function of the engine's dynamic state, i.e., the position, direction, and
+///        timing of each playhead and the state of each stateful node, so the music repeats exactly once the state at the start of
+///        a tick recurs. The hash of the state is compared with a checkpoint whose distance from the current tick doubles each time
+///        the checkpoint is moved, i.e., Brent's algorithm, which finds the length of a cycle without storing the states of every tick.
+///        The visits of each tick after the checkpoint are recorded, so when the cycle is found, its period can be replayed without
+///        resolving any moves. The detector is owned by the thread that owns the engine. The recording is allocated on demand,
+///        and no cycle can be found while it isn't allocated.
+
+template <typename Visit>
+class SequencerLoop
+{
+public:
+    /// @brief Allocate the recording if it hasn't been allocated yet.
+    /// @throw An exception will be thrown if the memory can't be allocated.
+
+    inline void allocate() noexcept(false)
+    {
+        if (!ticks.empty())
+        {
+            return;
+        }
+
+        ticks.resize(MAXIMUM_LENGTH);
+        visits.resize(MAXIMUM_VISITS);
+        positions.resize(MAXIMUM_POSITIONS);
+    }
+
+    /// @brief Forget the cycle and free the recording.
+
+    inline void deallocate() noexcept
+    {
+        reset();
+
+        std::vector<Tick>().swap(ticks);
+        std::vector<Entry>().swap(visits);
+        std::vector<Position>().swap(positions);
+    }
+
+public:
+    /// @brief Forget the cycle and the recording, e.g., after an edit has changed the behaviour of the simulation.
+
+    inline void reset() noexcept
+    {
+        length = 0;
+        power  = 1;
+        hasCheckpoint = false;
+        hasOverflowed = false;
+        isRecordingComplete = false;
+    }
+
+    /// @brief Return the length of the cycle in ticks, or zero if no cycle has been found since the detector was reset.
+
+    inline uint64_t getLength() const noexcept
+    {
+        return length;
+    }
+
+    /// @brief Indicate whether a cycle has been found and its period has been recorded, in which case it should be replayed.
+
+    inline bool isReplaying() const noexcept
+    {
+        return length > 0 && isRecordingComplete;
+    }
+
+    /// @brief Indicate whether a cycle that can be replayed could still be found, i.e., whether no cycle has been found yet and
+    ///        the ticks since the checkpoint still fit in the recording.
+
+    inline bool isSearching() const noexcept
+    {
+        return length == 0 && power <= MAXIMUM_LENGTH && !hasOverflowed;
+    }
+
+// MARK: - Detection
+
+public:
+    /// @brief Record a visit made during the tick being simulated.
+    /// @param visit The visit.
+    /// @param offset The offset of the visit within its tick.
+    /// @param enabled Whether the visiting playhead broadcasts the notes it lands on or not.
+
+    inline void record(const Visit& visit, uint16_t offset, bool enabled) noexcept
+    {
+        if (!isRecording())
+        {
+            return;
+        }
+
+        if (numberOfVisits == visits.size())
+        {
+            hasOverflowed = true;
+            return;
+        }
+
+        visits[numberOfVisits++] = {visit, offset, enabled};
+    }
+
+    /// @brief Complete the record of the tick that has been simulated.
+    /// @param playheads The playheads after the tick, whose positions and directions are recorded.
+
+    inline void close(const EnginePlayheads& playheads) noexcept
+    {
+        if (!isRecording())
+        {
+            return;
+        }
+
+        const size_t count = playheads.size();
+
+        if (numberOfTicks == ticks.size() || numberOfPositions + count > positions.size())
+        {
+            hasOverflowed = true;
+            return;
+        }
+
+        ticks[numberOfTicks++] = {firstVisit, numberOfVisits - firstVisit, numberOfPositions};
+
+        for (size_t k = 0; k < count; ++k)
+        {
+            positions[numberOfPositions++] = {playheads.x[k], playheads.y[k], playheads.dx[k], playheads.dy[k]};
+        }
+
+        firstVisit = numberOfVisits;
+    }
+
+    /// @brief Compare the state at the start of the given tick with the checkpoint.
+    /// @param tick The absolute index of the tick.
+    /// @param hash The hash of the engine's dynamic state at the start of the tick.
+
+    inline void observe(uint64_t tick, uint64_t hash) noexcept
+    {
+        if (length > 0)
+        {
+            return;
+        }
+
+        if (hasCheckpoint && hash == checkpointHash)
+        {
+            length = tick - checkpoint;
+            isRecordingComplete = !hasOverflowed && numberOfTicks == length;
+            return;
+        }
+
+        // The checkpoint is moved to the current tick each time the distance between them reaches a power of two.
+
+        if (!hasCheckpoint || tick - checkpoint >= power)
+        {
+            power = hasCheckpoint ? power * 2 : 1;
+            checkpoint = tick;
+            checkpointHash = hash;
+            hasCheckpoint = true;
+
+            numberOfTicks = 0;
+            numberOfVisits = 0;
+            numberOfPositions = 0;
+            firstVisit = 0;
+            hasOverflowed = false;
+        }
+    }
+
+// MARK: - Replay
+
+public:
+    /// @brief Replay the recorded tick that corresponds to the given tick.
+    /// @param tick The absolute index of the tick being simulated.
+    /// @param playheads The playheads, whose positions and directions are restored to their state after the tick.
+    /// @param commit A callable object that accepts each recorded visit, its offset within its tick, and whether its playhead
+    ///        broadcasts notes, in the order in which the visits were made.
+    /// @note  A cycle must have been recorded.
+
+    template <typename Commit>
+    inline void replay(uint64_t tick, EnginePlayheads& playheads, Commit && commit) const noexcept
+    {
+        const Tick & record = ticks[(tick - checkpoint) % length];
+
+        for (size_t k = 0; k < record.numberOfVisits; ++k)
+        {
+            const Entry & entry = visits[record.firstVisit + k];
+
+            commit(entry.visit, entry.offset, entry.enabled);
+        }
+
+        const size_t count = playheads.size();
+
+        for (size_t k = 0; k < count; ++k)
+        {
+            const Position & position = positions[record.firstPosition + k];
+
+            playheads.x[k]  = position.x;
+            playheads.y[k]  = position.y;
+            playheads.dx[k] = position.dx;
+            playheads.dy[k] = position.dy;
+        }
+    }
+
+private:
+    /// @brief Indicate whether the ticks after the checkpoint are being recorded.
+
+    inline bool isRecording() const noexcept
+    {
+        return hasCheckpoint && length == 0 && !hasOverflowed;
+    }
+
+public:
+    /// @brief The greatest number of ticks in a cycle that can be replayed.
+
+    constexpr static size_t MAXIMUM_LENGTH = 4096;
+
+private:
+    /// @brief The greatest number of visits that can be recorded across every tick of a cycle.
+
+    constexpr static size_t MAXIMUM_VISITS = 65536;
+
+    /// @brief The greatest number of playhead positions that can be recorded across every tick of a cycle.
+
+    constexpr static size_t MAXIMUM_POSITIONS = 65536;
+
+    /// @brief A recorded visit.
+
+    struct Entry
+    {
+        Visit    visit;
+        uint16_t offset;
+        bool     enabled;
+    };
+
+    /// @brief The position and direction of a playhead after a recorded tick.
+
+    struct Position
+    {
+        int32_t x;
+        int32_t y;
+        int32_t dx;
+        int32_t dy;
+    };
+
+    /// @brief A recorded tick, which refers to its visits and to the positions of the playheads after the tick.
+
+    struct Tick
+    {
+        size_t firstVisit;
+        size_t numberOfVisits;
+        size_t firstPosition;
+    };
+
+private:
+    std::vector<Tick> ticks;
+    std::vector<Entry> visits;
+    std::vector<Position> positions;
+
+    size_t numberOfTicks     = 0;
+    size_t numberOfVisits    = 0;
+    size_t numberOfPositions = 0;
+
+    /// @brief The index of the first visit of the tick being recorded.
+
+    size_t firstVisit = 0;
+
+    /// @brief Whether the recording has run out of room, in which case a cycle can be found but not replayed.
+
+    bool hasOverflowed = false;
+
+    /// @brief Whether the recording holds one period of the cycle that has been found.
+
+    bool isRecordingComplete = false;
+
+private:
+    /// @brief The absolute index of the tick whose state is compared with the state at the start of each later tick.
+
+    uint64_t checkpoint = 0;
+    uint64_t checkpointHash = 0;
+    bool hasCheckpoint = false;
+
+    /// @brief The number of ticks after which the checkpoint is moved.
+
+    uint64_t power = 1;
+
+    uint64_t length = 0;
+};
+
+#endif
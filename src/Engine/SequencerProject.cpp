@@ -0,0 +1,458 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#include "SequencerProject.hpp"
+#include "MappedFile.h"
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+bool SequencerProject::save(SequencerEngine& engine, const std::string& path) noexcept
+{
+    static_assert(sizeof(Header) == 56 && sizeof(NodeRecord) == 12 && sizeof(PlayheadRecord) == 40 &&
+                  sizeof(PortalRecord) == 4 && sizeof(SubsequenceRecord) == 322, "Records should have no padding.");
+
+    try
+    {
+        engine.rewind();
+
+        std::vector<NodeRecord> nodes;
+        std::vector<SubsequenceRecord> subsequences;
+
+        nodes.reserve(engine.grid.size());
+
+        engine.grid.forEach([&](const EngineNode & node, int x, int y)
+        {
+            NodeRecord record = {static_cast<uint16_t>(x), static_cast<uint16_t>(y), node.type, 0, 0, 0, 0, 0};
+
+            switch (node.type)
+            {
+                case Redirect:
+                {
+                    record.kind   = node.redirect.redirection;
+                    record.flag   = node.redirect.state;
+                    record.choice = node.redirect.choice;
+                    record.a      = node.redirect.counter;
+                    break;
+                }
+
+                case Portal:
+                {
+                    record.kind = node.portal.type;
+                    record.flag = node.portal.paired;
+                    record.a    = node.portal.x;
+                    record.b    = node.portal.y;
+                    break;
+                }
+
+                case Subsequence:
+                {
+                    const EngineSubsequence & sequence = engine.subsequences[node.subsequence.index];
+
+                    SubsequenceRecord subsequence = {sequence.length, sequence.index, {}};
+
+                    for (size_t k = 0; k < sequence.notes.size(); ++k)
+                    {
+                        const MIDINote & note = sequence.notes[k];
+                        subsequence.notes[k] = {note.note, note.midi.octave, note.midi.channel, note.midi.duration, note.midi.velocity};
+                    }
+
+                    record.a = static_cast<uint16_t>(subsequences.size());
+                    subsequences.push_back(subsequence);
+                    break;
+                }
+
+                default: break;
+            }
+
+            nodes.push_back(record);
+        });
+
+        Header header;
+        header.magic     = MAGIC;
+        header.byteOrder = BYTE_ORDER_MARK;
+        header.version   = VERSION;
+        header.numberOfNodes           = static_cast<uint32_t>(nodes.size());
+        header.numberOfPlayheads       = static_cast<uint32_t>(engine.playheads.size());
+        header.numberOfUnpairedPortals = static_cast<uint32_t>(engine.unpairedPortals.size());
+        header.numberOfSubsequences    = static_cast<uint32_t>(subsequences.size());
+        header.width    = engine.gridSize.w;
+        header.height   = engine.gridSize.h;
+        header.reserved = 0;
+        header.seed     = engine.random.getSeed();
+        header.position = engine.lookahead.getCommittedTick();
+
+        const Layout layout = getLayout(header);
+
+        std::vector<uint8_t> bytes(layout.size, 0);
+        std::memcpy(bytes.data(), &header, sizeof(Header));
+        std::copy(nodes.begin(), nodes.end(), reinterpret_cast<NodeRecord*>(bytes.data() + layout.nodes));
+        std::copy(subsequences.begin(), subsequences.end(), reinterpret_cast<SubsequenceRecord*>(bytes.data() + layout.subsequences));
+
+        PlayheadRecord * playheads = reinterpret_cast<PlayheadRecord*>(bytes.data() + layout.playheads);
+
+        for (size_t k = 0; k < engine.playheads.size(); ++k)
+        {
+            const EnginePlayhead playhead = engine.playheads.get(k);
+
+            playheads[k] = {playhead.xy.x, playhead.xy.y, playhead.delta.x, playhead.delta.y, playhead.moves, playhead.origin,
+                            playhead.multiplier, playhead.divider, playhead.enabled, 0, 0};
+        }
+
+        PortalRecord * portals = reinterpret_cast<PortalRecord*>(bytes.data() + layout.portals);
+
+        for (size_t k = 0; k < engine.unpairedPortals.size(); ++k)
+        {
+            const UIPoint<int>& xy = engine.unpairedPortals[k];
+
+            portals[k] = {static_cast<uint16_t>(xy.x), static_cast<uint16_t>(xy.y)};
+        }
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+        return file.good();
+    }
+
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+bool SequencerProject::load(SequencerEngine& engine, const std::string& path) noexcept
+{
+    try
+    {
+        const MappedFile file(path);
+
+        if (!file.isOpen() || file.size() < sizeof(Header))
+        {
+            return false;
+        }
+
+        const uint8_t * bytes = file.data();
+        const Header & header = *reinterpret_cast<const Header*>(bytes);
+
+        if (header.magic != MAGIC || header.byteOrder != BYTE_ORDER_MARK || header.version != VERSION)
+        {
+            return false;
+        }
+
+        if (header.numberOfNodes        > SequencerEngine::MAXIMUM_NODES     ||
+            header.numberOfPlayheads    > SequencerEngine::MAXIMUM_PLAYHEADS ||
+            header.numberOfSubsequences > SequencerEngine::MAXIMUM_SUBSEQUENCES ||
+            header.numberOfUnpairedPortals > header.numberOfNodes)
+        {
+            return false;
+        }
+
+        const Layout layout = getLayout(header);
+
+        if (file.size() < layout.size || !validate(bytes))
+        {
+            return false;
+        }
+
+        // The records are read in place from the mapped file, and the engine is only modified once the project is known to be valid.
+
+        const NodeRecord        * nodes        = reinterpret_cast<const NodeRecord*>(bytes + layout.nodes);
+        const PlayheadRecord    * playheads    = reinterpret_cast<const PlayheadRecord*>(bytes + layout.playheads);
+        const PortalRecord      * portals      = reinterpret_cast<const PortalRecord*>(bytes + layout.portals);
+        const SubsequenceRecord * subsequences = reinterpret_cast<const SubsequenceRecord*>(bytes + layout.subsequences);
+
+        engine.clear(header.position);
+        engine.gridSize.set(header.width, header.height);
+        engine.random.setSeed(header.seed);
+
+        for (size_t k = 0; k < header.numberOfSubsequences; ++k)
+        {
+            const SubsequenceRecord & record = subsequences[k];
+
+            EngineSubsequence sequence;
+            sequence.length = record.length;
+            sequence.index  = record.index;
+
+            for (size_t n = 0; n < sequence.notes.size(); ++n)
+            {
+                const NoteRecord & note = record.notes[n];
+
+                sequence.notes[n].note = note.note;
+                sequence.notes[n].midi = {note.octave, note.channel, note.duration, note.velocity};
+            }
+
+            engine.subsequences.push_back(sequence);
+        }
+
+        for (size_t k = 0; k < header.numberOfNodes; ++k)
+        {
+            engine.grid.set(makeNode(nodes[k]), nodes[k].x, nodes[k].y);
+        }
+
+        for (size_t k = 0; k < header.numberOfUnpairedPortals; ++k)
+        {
+            engine.unpairedPortals.emplace_back(portals[k].x, portals[k].y);
+        }
+
+        for (size_t k = 0; k < header.numberOfPlayheads; ++k)
+        {
+            const PlayheadRecord & record = playheads[k];
+
+            EnginePlayhead playhead;
+            playhead.xy.set(record.x, record.y);
+            playhead.delta.set(record.dx, record.dy);
+            playhead.moves      = record.moves;
+            playhead.origin     = record.origin;
+            playhead.multiplier = record.multiplier;
+            playhead.divider    = record.divider;
+            playhead.enabled    = record.enabled;
+
+            engine.playheads.push(playhead);
+        }
+
+        return true;
+    }
+
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+// MARK: - Format
+
+SequencerProject::Layout SequencerProject::getLayout(const Header& header) noexcept
+{
+    Layout layout;
+    layout.nodes        = align(sizeof(Header));
+    layout.playheads    = align(layout.nodes     + header.numberOfNodes           * sizeof(NodeRecord));
+    layout.portals      = align(layout.playheads + header.numberOfPlayheads       * sizeof(PlayheadRecord));
+    layout.subsequences = align(layout.portals   + header.numberOfUnpairedPortals * sizeof(PortalRecord));
+    layout.size         = layout.subsequences    + header.numberOfSubsequences    * sizeof(SubsequenceRecord);
+
+    return layout;
+}
+
+bool SequencerProject::validate(const uint8_t* bytes) noexcept(false)
+{
+    const Header & header = *reinterpret_cast<const Header*>(bytes);
+    const Layout   layout = getLayout(header);
+
+    const NodeRecord        * nodes        = reinterpret_cast<const NodeRecord*>(bytes + layout.nodes);
+    const PlayheadRecord    * playheads    = reinterpret_cast<const PlayheadRecord*>(bytes + layout.playheads);
+    const PortalRecord      * portals      = reinterpret_cast<const PortalRecord*>(bytes + layout.portals);
+    const SubsequenceRecord * subsequences = reinterpret_cast<const SubsequenceRecord*>(bytes + layout.subsequences);
+
+    if (header.position > MAXIMUM_POSITION)
+    {
+        return false;
+    }
+
+    if (header.width  <= 0 || header.width  > SequencerEngine::MAXIMUM_GRID_SIZE ||
+        header.height <= 0 || header.height > SequencerEngine::MAXIMUM_GRID_SIZE)
+    {
+        return false;
+    }
+
+    const auto key = [](uint16_t x, uint16_t y) -> uint32_t
+    {
+        return static_cast<uint32_t>(x) << 16 | y;
+    };
+
+    // Each node is found by position through a sorted list of the positions of every node, so no position is occupied twice,
+    // the nodes fit in the engine's tiles, and every portal's pair can be checked.
+
+    std::vector<std::pair<uint32_t, uint32_t>> positions;
+    std::vector<uint32_t> tiles;
+    std::vector<uint8_t>  isReferenced(header.numberOfSubsequences, 0);
+
+    positions.reserve(header.numberOfNodes);
+    tiles.reserve(header.numberOfNodes);
+
+    for (uint32_t k = 0; k < header.numberOfNodes; ++k)
+    {
+        const NodeRecord & node = nodes[k];
+        const uint32_t tile = SparseGrid<EngineNode>::TILE_SIZE;
+
+        positions.emplace_back(key(node.x, node.y), k);
+        tiles.push_back(key(static_cast<uint16_t>(node.x / tile), static_cast<uint16_t>(node.y / tile)));
+
+        switch (node.type)
+        {
+            case Redirect:
+            {
+                if (node.kind > Redirection::Random || node.flag > 1 || node.choice > 2) return false;
+                break;
+            }
+
+            case Portal:
+            {
+                if (node.kind > PortalType::B || node.flag > 1) return false;
+                break;
+            }
+
+            case Subsequence:
+            {
+                if (node.a >= header.numberOfSubsequences || isReferenced[node.a]) return false;
+                isReferenced[node.a] = 1;
+                break;
+            }
+
+            default: return false;
+        }
+    }
+
+    std::sort(positions.begin(), positions.end());
+    std::sort(tiles.begin(), tiles.end());
+
+    const auto duplicate = std::adjacent_find(positions.begin(), positions.end(), [](const auto & a, const auto & b)
+    {
+        return a.first == b.first;
+    });
+
+    if (duplicate != positions.end())
+    {
+        return false;
+    }
+
+    if (static_cast<size_t>(std::unique(tiles.begin(), tiles.end()) - tiles.begin()) > SequencerEngine::MAXIMUM_TILES)
+    {
+        return false;
+    }
+
+    if (static_cast<size_t>(std::count(isReferenced.begin(), isReferenced.end(), 1)) != header.numberOfSubsequences)
+    {
+        return false;
+    }
+
+    const auto find = [&](uint32_t position) -> const NodeRecord *
+    {
+        const auto match = std::lower_bound(positions.begin(), positions.end(), std::make_pair(position, 0u));
+
+        return match != positions.end() && match->first == position ? &nodes[match->second] : nullptr;
+    };
+
+    // Paired portals must refer to each other and have opposite types, and each unpaired portal must be waiting to be paired.
+
+    uint32_t numberOfUnpairedPortals = 0;
+
+    for (uint32_t k = 0; k < header.numberOfNodes; ++k)
+    {
+        const NodeRecord & node = nodes[k];
+
+        if (node.type != Portal) continue;
+
+        if (node.flag == 0)
+        {
+            numberOfUnpairedPortals = numberOfUnpairedPortals + 1;
+            continue;
+        }
+
+        const NodeRecord * pair = find(key(node.a, node.b));
+
+        if (pair == nullptr || pair->type != Portal || pair->flag == 0 || pair->kind == node.kind ||
+            pair->a != node.x || pair->b != node.y)
+        {
+            return false;
+        }
+    }
+
+    if (numberOfUnpairedPortals != header.numberOfUnpairedPortals)
+    {
+        return false;
+    }
+
+    std::vector<uint32_t> unpaired;
+    unpaired.reserve(header.numberOfUnpairedPortals);
+
+    for (uint32_t k = 0; k < header.numberOfUnpairedPortals; ++k)
+    {
+        const NodeRecord * portal = find(key(portals[k].x, portals[k].y));
+
+        if (portal == nullptr || portal->type != Portal || portal->flag != 0) return false;
+
+        unpaired.push_back(key(portals[k].x, portals[k].y));
+    }
+
+    std::sort(unpaired.begin(), unpaired.end());
+
+    if (std::adjacent_find(unpaired.begin(), unpaired.end()) != unpaired.end())
+    {
+        return false;
+    }
+
+    for (uint32_t k = 0; k < header.numberOfPlayheads; ++k)
+    {
+        const PlayheadRecord & playhead = playheads[k];
+
+        if (playhead.x < 0 || playhead.x >= header.width || playhead.y < 0 || playhead.y >= header.height)
+            return false;
+
+        if (std::abs(playhead.dx) > 1 || std::abs(playhead.dy) > 1 || playhead.enabled > 1)
+            return false;
+
+        if (playhead.multiplier < 1 || playhead.multiplier > EnginePlayhead::MAXIMUM_RATE ||
+            playhead.divider    < 1 || playhead.divider    > EnginePlayhead::MAXIMUM_RATE)
+            return false;
+
+        // Each playhead must have made every move that precedes the engine's position, and none that follows it.
+
+        EnginePlayhead timing;
+        timing.origin     = playhead.origin;
+        timing.multiplier = playhead.multiplier;
+        timing.divider    = playhead.divider;
+
+        if (playhead.origin > MAXIMUM_POSITION || playhead.moves != timing.getNumberOfMovesBefore(header.position))
+            return false;
+    }
+
+    for (uint32_t k = 0; k < header.numberOfSubsequences; ++k)
+    {
+        const SubsequenceRecord & subsequence = subsequences[k];
+
+        if (subsequence.length > subsequence.notes.size() || subsequence.index >= std::max<size_t>(subsequence.length, 1))
+            return false;
+
+        // Each note's settings must be in the ranges that the cursor enforces, and a note must last at least one tick.
+
+        for (const NoteRecord & note : subsequence.notes)
+        {
+            if (note.note > 127 || note.octave > 6 || note.channel < 1 || note.channel > 16 ||
+                note.duration < 1 || note.duration > 8 || note.velocity < 1 || note.velocity > 127)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+EngineNode SequencerProject::makeNode(const NodeRecord& record) noexcept
+{
+    EngineNode node;
+    node.type = static_cast<SQNodeType>(record.type);
+
+    switch (node.type)
+    {
+        case Redirect:
+        {
+            node.redirect = {static_cast<Redirection>(record.kind), record.flag != 0, record.choice, record.a};
+            break;
+        }
+
+        case Portal:
+        {
+            node.portal = {static_cast<PortalType>(record.kind), record.flag != 0, record.a, record.b};
+            break;
+        }
+
+        case Subsequence:
+        {
+            node.subsequence = {record.a};
+            break;
+        }
+
+        default: break;
+    }
+
+    return node;
+}
@@ -0,0 +1,188 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef SEQUENCERPROJECT_HPP
+#define SEQUENCERPROJECT_HPP
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "SequencerEngine.hpp"
+
+/// @brief The binary project format of the Ensemble sequencer, which holds the contents of a sequencer engine and its live state.
+/// @note  A project is a header followed by sections of fixed-size records for the nodes, the playheads, the unpaired portals,
+///        and the subsequences. Each section begins at a multiple of eight bytes, so a project is loaded by mapping the file
+///        into memory and reading its records in place, without parsing or copying the file. The live state, i.e., the state of
+///        each redirect and subsequence and the position and timing of each playhead, is saved as of the engine's earliest
+///        undispatched tick, so a show resumes exactly where it was saved. Multi-byte fields are stored in the byte order of
+///        the machine that saved the project, which is recorded in the header, and projects with the other byte order are rejected.
+
+class SequencerProject
+{
+public:
+    /// @brief Write the given engine's contents and live state to the given path.
+    /// @param engine The engine, whose simulated ticks are discarded so that its state matches its earliest undispatched tick.
+    /// @param path The path of the file to be written.
+    /// @return A Boolean value to indicate whether the file was written successfully or not.
+    /// @note  The engine must not be modified by another thread during the save.
+
+    static bool save(SequencerEngine& engine, const std::string& path) noexcept;
+
+    /// @brief Replace the given engine's contents and live state with the project at the given path.
+    /// @param engine The engine, which is left unmodified if the project can't be loaded.
+    /// @param path The path of the project.
+    /// @return A Boolean value to indicate whether the project was loaded successfully or not.
+    /// @note  The project is validated in full before the engine is modified. The engine must not be modified by another thread
+    ///        during the load.
+
+    static bool load(SequencerEngine& engine, const std::string& path) noexcept;
+
+public:
+    /// @brief The version of the format written by `save`.
+
+    constexpr static uint32_t VERSION = 1;
+
+private:
+    /// @brief The first bytes of every project.
+
+    constexpr static std::array<char, 4> MAGIC = {'E', 'N', 'S', 'M'};
+
+    /// @brief A number whose bytes are distinct, which identifies the byte order of the machine that saved a project.
+
+    constexpr static uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    /// @brief The greatest position or playhead origin that can be loaded, beyond which the times of moves could overflow.
+
+    constexpr static uint64_t MAXIMUM_POSITION = 1ull << 48;
+
+    struct Header
+    {
+        std::array<char, 4> magic;
+        uint32_t byteOrder;
+        uint32_t version;
+
+        uint32_t numberOfNodes;
+        uint32_t numberOfPlayheads;
+        uint32_t numberOfUnpairedPortals;
+        uint32_t numberOfSubsequences;
+
+        /// @brief The dimensions of the grid in rows and columns.
+
+        int32_t  width;
+        int32_t  height;
+
+        uint32_t reserved;
+
+        /// @brief The seed from which the choices of Random redirects are derived.
+
+        uint64_t seed;
+
+        /// @brief The absolute index of the engine's earliest undispatched tick, from which each playhead's timing is measured.
+
+        uint64_t position;
+    };
+
+    /// @brief A node and its position.
+
+    struct NodeRecord
+    {
+        uint16_t x;
+        uint16_t y;
+        uint8_t  type;
+
+        /// @brief The type of a redirect or a portal.
+
+        uint8_t  kind;
+
+        /// @brief The state of an Alternating redirect, or whether a portal is paired.
+
+        uint8_t  flag;
+
+        /// @brief The choice of a Random redirect.
+
+        uint8_t  choice;
+
+        /// @brief The counter of a Random redirect, the column of a portal's pair, or the index of a subsequence's record.
+
+        uint16_t a;
+
+        /// @brief The row of a portal's pair.
+
+        uint16_t b;
+    };
+
+    /// @brief A playhead, whose selection by the user isn't saved.
+
+    struct PlayheadRecord
+    {
+        int32_t  x;
+        int32_t  y;
+        int32_t  dx;
+        int32_t  dy;
+        uint64_t moves;
+        uint64_t origin;
+        uint8_t  multiplier;
+        uint8_t  divider;
+        uint8_t  enabled;
+        uint8_t  padding;
+        uint32_t reserved;
+    };
+
+    /// @brief The position of a portal that's waiting to be paired.
+
+    struct PortalRecord
+    {
+        uint16_t x;
+        uint16_t y;
+    };
+
+    struct NoteRecord
+    {
+        uint8_t note;
+        uint8_t octave;
+        uint8_t channel;
+        uint8_t duration;
+        uint8_t velocity;
+    };
+
+    struct SubsequenceRecord
+    {
+        uint8_t length;
+        uint8_t index;
+        std::array<NoteRecord, 64> notes;
+    };
+
+    /// @brief The offset of each section of a project.
+
+    struct Layout
+    {
+        size_t nodes;
+        size_t playheads;
+        size_t portals;
+        size_t subsequences;
+        size_t size;
+    };
+
+    /// @brief Compute the offset of each section of a project with the given header.
+
+    static Layout getLayout(const Header& header) noexcept;
+
+    /// @brief Round the given offset up to the next multiple of eight bytes.
+
+    inline static size_t align(size_t offset) noexcept
+    {
+        return (offset + 7) & ~static_cast<size_t>(7);
+    }
+
+    /// @brief Indicate whether the given project's records describe a valid state of the engine.
+    /// @param bytes The contents of the project, whose header and size have been validated.
+
+    static bool validate(const uint8_t* bytes) noexcept(false);
+
+    /// @brief Convert the given record to a node, whose subsequence is stored at the index of its record in the engine's pool.
+
+    static EngineNode makeNode(const NodeRecord& record) noexcept;
+};
+
+#endif
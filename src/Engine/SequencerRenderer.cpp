@@ -0,0 +1,107 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#include "SequencerRenderer.hpp"
+
+SequencerRenderer::SequencerRenderer()
+{
+    voices.setPolyphony(DEFAULT_POLYPHONY);
+}
+
+void SequencerRenderer::render(SequencerEngine& engine, uint64_t bars, MIDIFileWriter& file) noexcept(false)
+{
+    const uint64_t length = bars * beatsPerBar * ticksPerBeat;
+
+    file.setTempo(tempo);
+    file.setTimeSignature(beatsPerBar, 4);
+    file.setLength(toPulses(length, 0, file));
+
+    voices.clear([](const MIDINote &) {});
+
+    // The voices measure each note's duration in ticks, as the MIDI server does.
+
+    uint64_t ticks = 0;
+    uint64_t time  = 0;
+
+    const auto collect = [&](const MIDIEvent & event)
+    {
+        if (batch.isFull())
+        {
+            flush(file);
+        }
+
+        batch.collect(event);
+    };
+
+    const auto release = [&](const MIDINote & note)
+    {
+        collect(MIDIEvent::noteOff(note, time));
+    };
+
+    for (uint64_t tick = 0; tick < length;)
+    {
+        // While no note is held, the render fast-forwards to the tick before the next node is reached.
+
+        if (voices.size() == 0)
+        {
+            const uint64_t skipped = engine.skip(length - tick);
+
+            tick  = tick  + skipped;
+            ticks = ticks + skipped;
+
+            if (tick == length) break;
+        }
+
+        engine.simulate(1);
+
+        time  = toPulses(tick, 0, file);
+        ticks = ticks + 1;
+
+        voices.advance(ticks, release);
+
+        engine.dispatch([&](const MIDINote & note, uint16_t offset)
+        {
+            time = toPulses(tick, offset, file);
+
+            if (voices.allocate(note, ticks + note.midi.duration, release))
+            {
+                collect(MIDIEvent::noteOn(note, time));
+            }
+        });
+
+        flush(file);
+
+        tick = tick + 1;
+    }
+
+    time = toPulses(length, 0, file);
+
+    voices.clear(release);
+
+    flush(file);
+}
+
+bool SequencerRenderer::render(SequencerEngine& engine, uint64_t bars, const std::string& path) noexcept
+{
+    try
+    {
+        MIDIFileWriter file;
+
+        render(engine, bars, file);
+
+        return file.save(path);
+    }
+
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+void SequencerRenderer::flush(MIDIFileWriter& file) noexcept(false)
+{
+    batch.flush([&file](const MIDIEvent & event)
+    {
+        file.write(event, event.timestamp);
+    });
+}
@@ -0,0 +1,119 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef SEQUENCERRENDERER_HPP
+#define SEQUENCERRENDERER_HPP
+
+#include <string>
+#include <algorithm>
+#include <cstdint>
+#include "MIDIBatch.h"
+#include "MIDIFileWriter.h"
+#include "MIDIVoiceAllocator.h"
+#include "SequencerEngine.hpp"
+
+/// @brief A renderer that drives a sequencer engine without a clock and writes the notes it plays to a Standard MIDI File.
+/// @note  Each tick is simulated and dispatched as soon as the previous tick has been written, and stretches of silence are skipped
+///        without simulating each move, so a render runs as fast as the engine can simulate. Notes are held and released as they
+///        would be by the MIDI server during playback, so the file matches what would be heard at the given tempo.
+
+class SequencerRenderer
+{
+public:
+    SequencerRenderer();
+
+public:
+    /// @brief Set the tempo of the render.
+    /// @param bpm The tempo in beats per minute.
+
+    inline void setTempo(double bpm) noexcept
+    {
+        tempo = bpm;
+    }
+
+    /// @brief Set the number of ticks of the sequencer per beat, which is the clock's subdivision during playback.
+    /// @param ticks The number of ticks per beat.
+
+    inline void setTicksPerBeat(uint32_t ticks) noexcept
+    {
+        ticksPerBeat = std::max<uint32_t>(ticks, 1);
+    }
+
+    /// @brief Set the number of beats per bar.
+    /// @param beats The number of beats per bar.
+
+    inline void setBeatsPerBar(uint8_t beats) noexcept
+    {
+        beatsPerBar = std::max<uint8_t>(beats, 1);
+    }
+
+    /// @brief Set the maximum number of notes that can be held simultaneously across all channels.
+    /// @param voices The desired number of voices.
+
+    inline void setPolyphony(unsigned int voices) noexcept
+    {
+        this->voices.setPolyphony(voices);
+    }
+
+    /// @brief Set the policy that determines which note is released when the polyphony limit is reached.
+    /// @param policy The desired voice stealing policy.
+
+    inline void setVoiceStealingPolicy(VoiceStealing policy) noexcept
+    {
+        voices.setStealingPolicy(policy);
+    }
+
+public:
+    /// @brief Render the given number of bars from the engine's current state, beginning with its earliest undispatched tick.
+    /// @param engine The engine to be rendered, which is advanced by the render.
+    /// @param bars The number of bars to be rendered.
+    /// @param file The file to which the notes are written.
+
+    void render(SequencerEngine& engine, uint64_t bars, MIDIFileWriter& file) noexcept(false);
+
+    /// @brief Render the given number of bars from the engine's current state and write a Standard MIDI File to the given path.
+    /// @param engine The engine to be rendered, which is advanced by the render.
+    /// @param bars The number of bars to be rendered.
+    /// @param path The path of the file to be written.
+    /// @return A Boolean value to indicate whether the file was written successfully or not.
+
+    bool render(SequencerEngine& engine, uint64_t bars, const std::string& path) noexcept;
+
+private:
+    /// @brief Convert the given time to a number of pulses of the given file.
+    /// @param tick The index of a tick from the start of the render.
+    /// @param offset The offset within the tick in units of `1 / EnginePlayhead::TICK_RESOLUTION` ticks.
+
+    inline uint64_t toPulses(uint64_t tick, uint64_t offset, const MIDIFileWriter& file) const noexcept
+    {
+        const uint64_t time  = tick * EnginePlayhead::TICK_RESOLUTION + offset;
+        const uint64_t scale = static_cast<uint64_t>(ticksPerBeat) * EnginePlayhead::TICK_RESOLUTION;
+
+        return (time * file.getDivision() + scale / 2) / scale;
+    }
+
+    /// @brief Write each of the collected events to the given file.
+
+    void flush(MIDIFileWriter& file) noexcept(false);
+
+private:
+    /// @brief The number of notes that can be held simultaneously across all channels by default, as in the MIDI server.
+
+    constexpr static unsigned int DEFAULT_POLYPHONY = 16;
+
+private:
+    double   tempo        = 120.0;
+    uint32_t ticksPerBeat = 4;
+    uint8_t  beatsPerBar  = 4;
+
+private:
+    /// @brief The allocator of the voices that hold each note until it should be released.
+
+    MIDIVoiceAllocator<512> voices;
+
+    /// @brief The events produced during the current tick, whose timestamps are in pulses.
+
+    MIDIBatch batch;
+};
+
+#endif
@@ -0,0 +1,130 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef MIDIBATCH_H
+#define MIDIBATCH_H
+
+#include <array>
+#include <bitset>
+#include "MIDIEvent.h"
+
+/// @brief The MIDI events produced during one clock tick, which are collected in the order of their timestamps and released together.
+/// @note  Identical note on messages with the same timestamp are released once, and note off messages are released before note on
+///        messages with the same timestamp so that a retriggered note is released before it sounds again.
+
+class MIDIBatch
+{
+public:
+    /// @brief Indicate whether the batch has no room for another event.
+
+    inline bool isFull() const noexcept
+    {
+        return size == MAXIMUM_BATCH_SIZE;
+    }
+
+    /// @brief Add the given event to the batch.
+    /// @param event The event to be collected, whose timestamp must not precede the timestamp of any collected event.
+    /// @note  The batch must not be full.
+
+    inline void collect(const MIDIEvent& event) noexcept
+    {
+        batch[size] = event;
+        size = size + 1;
+    }
+
+    /// @brief Pass each of the collected events to the given callable in order, with duplicates removed, and empty the batch.
+    /// @param send A callable object that accepts each ordered event, which can throw an exception if the events can't be sent.
+
+    template <typename Callback>
+    void flush(Callback && send) noexcept(false)
+    {
+        if (size == 0)
+        {
+            return;
+        }
+
+        size_t count = 0;
+
+        // Events are collected in the order of their timestamps. Each run of events that share a timestamp is ordered separately,
+        // so notes that were scheduled between ticks aren't mistaken for duplicates of the same note at a different time.
+
+        for (size_t start = 0, end = 0; start < size; start = end)
+        {
+            while (end < size && batch[end].timestamp == batch[start].timestamp)
+            {
+                end = end + 1;
+            }
+
+            count = order(start, end, count);
+        }
+
+        size = 0;
+
+        for (size_t k = 0; k < count; ++k)
+        {
+            send(ordered[k]);
+        }
+    }
+
+private:
+    /// @brief Append the collected events in the given range, which share a timestamp, to the ordered events.
+    /// @param start The index of the first event in the range.
+    /// @param end The index after the last event in the range.
+    /// @param count The number of ordered events.
+    /// @return The number of ordered events after the given range has been appended.
+
+    inline size_t order(size_t start, size_t end, size_t count) noexcept
+    {
+        std::bitset<16 * 128> notesOff;
+        std::bitset<16 * 128> notesOn;
+
+        const auto key = [](const MIDIEvent & event) -> size_t
+        {
+            return (event.status & 0x0F) * 128 + (event.data1 & 0x7F);
+        };
+
+        for (size_t k = start; k < end; ++k)
+        {
+            const MIDIEvent & event = batch[k];
+
+            if (event.isNoteOff() && !notesOff.test(key(event)))
+            {
+                notesOff.set(key(event));
+                ordered[count++] = event;
+            }
+        }
+
+        for (size_t k = start; k < end; ++k)
+        {
+            const MIDIEvent & event = batch[k];
+
+            if (event.isNoteOn() && !notesOn.test(key(event)))
+            {
+                notesOn.set(key(event));
+                ordered[count++] = event;
+            }
+        }
+
+        return count;
+    }
+
+private:
+    /// @brief The maximum number of events that can be collected before the batch is flushed.
+
+    constexpr static size_t MAXIMUM_BATCH_SIZE = 256;
+
+private:
+    /// @brief The events collected since the last flush.
+
+    std::array<MIDIEvent, MAXIMUM_BATCH_SIZE> batch;
+
+    /// @brief The collected events, with duplicates removed and note off messages first.
+
+    std::array<MIDIEvent, MAXIMUM_BATCH_SIZE> ordered;
+
+    /// @brief The number of events collected since the last flush.
+
+    size_t size = 0;
+};
+
+#endif
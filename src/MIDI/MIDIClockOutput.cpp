@@ -0,0 +1,130 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#include "MIDIClockOutput.h"
+#include "ClockTick.h"
+
+void MIDIClockOutput::setEnabled(bool shouldBeEnabled) noexcept
+{
+    if (enabled.exchange(shouldBeEnabled) == shouldBeEnabled)
+    {
+        return;
+    }
+
+    if (running.load())
+    {
+        transport.store(shouldBeEnabled ? Transport::Continue : Transport::Stop);
+    }
+}
+
+// MARK: - Transport
+
+void MIDIClockOutput::pulse(uint64_t timestamp) noexcept
+{
+    const uint64_t position = pulses.load(std::memory_order_relaxed);
+
+    Transport message = transport.load();
+
+    // The Song Position Pointer can only describe positions on a sixteenth note, and the receiver resumes from that position
+    // on the pulse that follows Continue, so Continue is deferred until the pulse that begins the next sixteenth note.
+
+    const bool deferred = message == Transport::Continue && position % PULSES_PER_MIDI_BEAT != 0;
+
+    if (message != Transport::None && !deferred && transport.compare_exchange_strong(message, Transport::None))
+    {
+        send(message, position, timestamp);
+    }
+
+    if (enabled.load(std::memory_order_relaxed))
+    {
+        sender.enqueue(MIDIEvent::realtime(MIDIEvent::TimingClock, timestamp));
+    }
+
+    pulses.store(position + 1, std::memory_order_relaxed);
+    this->timestamp.store(timestamp, std::memory_order_relaxed);
+}
+
+void MIDIClockOutput::start() noexcept
+{
+    running.store(true);
+
+    if (enabled.load())
+    {
+        transport.store(pulses.load() == 0 ? Transport::Start : Transport::Continue);
+    }
+}
+
+void MIDIClockOutput::stop() noexcept
+{
+    running.store(false);
+    transport.store(Transport::None);
+
+    if (enabled.load())
+    {
+        const uint64_t time = std::max(ClockTick::now(), timestamp.load() + 1);
+
+        send(Transport::Stop, pulses.load(), time);
+    }
+}
+
+void MIDIClockOutput::send(Transport message, uint64_t position, uint64_t timestamp) noexcept
+{
+    switch (message)
+    {
+        case Transport::None:
+            break;
+
+        case Transport::Start:
+            sender.enqueue(MIDIEvent::realtime(MIDIEvent::Start, timestamp));
+            break;
+
+        case Transport::Continue:
+        {
+            const uint64_t beats = std::min(position / PULSES_PER_MIDI_BEAT, MAXIMUM_SONG_POSITION);
+
+            sender.enqueue(MIDIEvent::songPosition(static_cast<uint16_t>(beats), timestamp));
+            sender.enqueue(MIDIEvent::realtime(MIDIEvent::Continue, timestamp));
+            break;
+        }
+
+        case Transport::Stop:
+            sender.enqueue(MIDIEvent::realtime(MIDIEvent::Stop, timestamp));
+            break;
+    }
+}
+
+// MARK: - MIDI port
+
+bool MIDIClockOutput::selectMIDIPort(unsigned int port) noexcept
+{
+    return sender.selectPort(port);
+}
+
+void MIDIClockOutput::selectNextMIDIPort() noexcept
+{
+    const int port  = sender.getPort();
+    const int ports = sender.getNumberOfPorts();
+    selectMIDIPort((port + 1) % ports);
+}
+
+void MIDIClockOutput::selectPreviousMIDIPort() noexcept
+{
+    const int port  = sender.getPort();
+    const int ports = sender.getNumberOfPorts();
+    selectMIDIPort((port - 1 + ports) % ports);
+}
+
+unsigned int MIDIClockOutput::getMIDIPort() noexcept
+{
+    return sender.getPort();
+}
+
+std::string MIDIClockOutput::getMIDIPortDescription() noexcept
+{
+    return sender.getPortDescription();
+}
+
+MIDISenderMetrics MIDIClockOutput::getSenderMetrics() const noexcept
+{
+    return sender.getMetrics();
+}
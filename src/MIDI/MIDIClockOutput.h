@@ -0,0 +1,120 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef MIDICLOCKOUTPUT_H
+#define MIDICLOCKOUTPUT_H
+
+#include <atomic>
+#include "MIDISender.h"
+#include "MIDITypes.h"
+
+/// @brief A MIDI clock master that sends 24-PPQN clock pulses, transport messages, and the song position on its own output port.
+/// @note  Pulses are stamped with the host time of the internal clock's beat grid and sent by a dedicated sender thread,
+///        so they share the timeline of the sequencer's note events. `pulse` is called by the thread that drives the clock, while
+///        `start` and `stop` are called by the thread that starts and stops the clock. The two never enqueue events at the same time:
+///        Start and Continue are sent by the clock's thread with the next pulse, and Stop is sent only after the clock has stopped.
+
+class MIDIClockOutput
+{
+public:
+    /// @brief Enable or disable the clock output.
+    /// @param shouldBeEnabled Whether clock pulses and transport messages should be sent or not.
+    /// @note  Enabling the output while the clock is running sends Continue, and disabling it sends Stop, with the next pulse.
+
+    void setEnabled(bool shouldBeEnabled) noexcept;
+
+    /// @brief Indicate whether the clock output is enabled or not.
+
+    inline bool isEnabled() const noexcept
+    {
+        return enabled.load();
+    }
+
+public:
+    /// @brief Send a clock pulse, preceded by any pending transport message.
+    /// @param timestamp The host time in microseconds at which the pulse should be realised.
+
+    void pulse(uint64_t timestamp) noexcept;
+
+    /// @brief Request that Start be sent with the next pulse, or Continue if the song position is not at its origin.
+    /// @note  This should be called immediately before the clock starts.
+
+    void start() noexcept;
+
+    /// @brief Send Stop after the last pulse that was sent.
+    /// @note  This should be called immediately after the clock has stopped.
+
+    void stop() noexcept;
+
+    /// @brief Return the song position in MIDI clock pulses since the clock was first started.
+
+    inline uint64_t getSongPosition() const noexcept
+    {
+        return pulses.load(std::memory_order_relaxed);
+    }
+
+public:
+    /// @brief Close the current MIDI port and open the given MIDI port.
+    /// @param port The number of the port to be opened.
+    /// @return A Boolean value indicating whether the given port was successfully opened or not.
+
+    bool selectMIDIPort(unsigned int port) noexcept;
+
+    /// @brief Open the next available MIDI port.
+
+    void selectNextMIDIPort() noexcept;
+
+    /// @brief Open the previous available MIDI port.
+
+    void selectPreviousMIDIPort() noexcept;
+
+    /// @brief Return the number of the open MIDI port.
+
+    unsigned int getMIDIPort() noexcept;
+
+    /// @brief Return the open MIDI port's textual description.
+
+    std::string getMIDIPortDescription() noexcept;
+
+    /// @brief Return a snapshot of the sender thread's queue depth and send latency.
+
+    MIDISenderMetrics getSenderMetrics() const noexcept;
+
+private:
+    /// @brief Constants defining the transport messages that can be pending dispatch with the next pulse.
+
+    enum class Transport { None, Start, Continue, Stop };
+
+    /// @brief Send the given transport message.
+    /// @param message The transport message to be sent.
+    /// @param position The song position in MIDI clock pulses.
+    /// @param timestamp The host time in microseconds at which the message should be sent.
+
+    void send(Transport message, uint64_t position, uint64_t timestamp) noexcept;
+
+    /// @brief The number of clock pulses per MIDI beat, i.e., per sixteenth note, which is the unit of the Song Position Pointer.
+
+    constexpr static uint64_t PULSES_PER_MIDI_BEAT = 6;
+
+    /// @brief The greatest song position that can be described by the Song Position Pointer in MIDI beats.
+
+    constexpr static uint64_t MAXIMUM_SONG_POSITION = 0x3FFF;
+
+private:
+    MIDISender sender;
+
+private:
+    std::atomic<bool> enabled = {false};
+    std::atomic<bool> running = {false};
+    std::atomic<Transport> transport = {Transport::None};
+
+    /// @brief The number of pulses since the clock was first started.
+
+    std::atomic<uint64_t> pulses = {0};
+
+    /// @brief The host time of the most recent pulse.
+
+    std::atomic<uint64_t> timestamp = {0};
+};
+
+#endif
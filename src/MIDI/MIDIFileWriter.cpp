@@ -0,0 +1,165 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#include "MIDIFileWriter.h"
+#include <cmath>
+#include <fstream>
+#include <algorithm>
+
+MIDIFileWriter::MIDIFileWriter(uint16_t division):
+division(std::min<uint16_t>(std::max<uint16_t>(division, 1), 0x7FFF))
+{
+
+}
+
+void MIDIFileWriter::setTempo(double bpm) noexcept
+{
+    tempo = static_cast<uint32_t>(std::clamp(std::round(60000000.0 / std::max(bpm, 1.0)), 1.0, 16777215.0));
+}
+
+void MIDIFileWriter::setTimeSignature(uint8_t numerator, uint8_t denominator) noexcept
+{
+    this->numerator   = std::max<uint8_t>(numerator, 1);
+    this->denominator = std::max<uint8_t>(denominator, 1);
+}
+
+void MIDIFileWriter::setLength(uint64_t time) noexcept
+{
+    length = time;
+}
+
+void MIDIFileWriter::write(const MIDIEvent& event, uint64_t time) noexcept(false)
+{
+    if (event.isSystem())
+    {
+        return;
+    }
+
+    Track & track = tracks[event.channel() - 1];
+
+    writeDelta(track, time);
+
+    track.data.push_back(event.status);
+    track.data.push_back(event.data1 & 0x7F);
+    track.data.push_back(event.data2 & 0x7F);
+}
+
+bool MIDIFileWriter::save(const std::string& path) const noexcept
+{
+    try
+    {
+        std::vector<uint8_t> bytes;
+
+        const size_t numberOfTracks = 1 + std::count_if(tracks.begin(), tracks.end(), [](const Track & track)
+        {
+            return !track.data.empty();
+        });
+
+        bytes.insert(bytes.end(), {'M', 'T', 'h', 'd'});
+        writeInteger(bytes, 6, 4);
+        writeInteger(bytes, 1, 2);
+        writeInteger(bytes, static_cast<uint32_t>(numberOfTracks), 2);
+        writeInteger(bytes, division, 2);
+
+        // The conductor track holds the tempo and the time signature, whose denominator is written as a power of two.
+
+        uint8_t exponent = 0;
+
+        while ((1u << (exponent + 1)) <= denominator)
+        {
+            exponent = exponent + 1;
+        }
+
+        Track conductor;
+        conductor.data = {0x00, 0xFF, 0x51, 0x03};
+        writeInteger(conductor.data, tempo, 3);
+        conductor.data.insert(conductor.data.end(), {0x00, 0xFF, 0x58, 0x04, numerator, exponent, 24, 8});
+
+        writeTrack(bytes, conductor);
+
+        for (size_t channel = 0; channel < tracks.size(); ++channel)
+        {
+            if (tracks[channel].data.empty()) continue;
+
+            const std::string name = "Channel " + std::to_string(channel + 1);
+
+            Track track;
+            track.data = {0x00, 0xFF, 0x03, static_cast<uint8_t>(name.size())};
+            track.data.insert(track.data.end(), name.begin(), name.end());
+            track.data.insert(track.data.end(), tracks[channel].data.begin(), tracks[channel].data.end());
+            track.time = tracks[channel].time;
+
+            writeTrack(bytes, track);
+        }
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+        return file.good();
+    }
+
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+// MARK: - Encoding
+
+void MIDIFileWriter::writeTrack(std::vector<uint8_t>& bytes, const Track& track) const noexcept(false)
+{
+    Track end;
+    end.time = track.time;
+
+    writeDelta(end, std::max(length, track.time));
+    end.data.insert(end.data.end(), {0xFF, 0x2F, 0x00});
+
+    bytes.insert(bytes.end(), {'M', 'T', 'r', 'k'});
+    writeInteger(bytes, static_cast<uint32_t>(track.data.size() + end.data.size()), 4);
+    bytes.insert(bytes.end(), track.data.begin(), track.data.end());
+    bytes.insert(bytes.end(), end.data.begin(), end.data.end());
+}
+
+void MIDIFileWriter::writeDelta(Track& track, uint64_t time) noexcept(false)
+{
+    uint64_t delta = time > track.time ? time - track.time : 0;
+
+    // A longer silence than a variable-length quantity can express is bridged by empty text events.
+
+    while (delta > MAXIMUM_DELTA)
+    {
+        writeVariableLengthQuantity(track.data, MAXIMUM_DELTA);
+        track.data.insert(track.data.end(), {0xFF, 0x01, 0x00});
+        delta = delta - MAXIMUM_DELTA;
+    }
+
+    writeVariableLengthQuantity(track.data, static_cast<uint32_t>(delta));
+    track.time = std::max(track.time, time);
+}
+
+void MIDIFileWriter::writeVariableLengthQuantity(std::vector<uint8_t>& bytes, uint32_t value) noexcept(false)
+{
+    uint8_t buffer[4];
+    size_t  size = 0;
+
+    do
+    {
+        buffer[size++] = value & 0x7F;
+        value = value >> 7;
+    }
+    while (value > 0 && size < 4);
+
+    while (size > 0)
+    {
+        size = size - 1;
+        bytes.push_back(buffer[size] | (size > 0 ? 0x80 : 0x00));
+    }
+}
+
+void MIDIFileWriter::writeInteger(std::vector<uint8_t>& bytes, uint32_t value, size_t size) noexcept(false)
+{
+    for (size_t k = size; k > 0; --k)
+    {
+        bytes.push_back(static_cast<uint8_t>(value >> (8 * (k - 1))));
+    }
+}
@@ -0,0 +1,109 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef MIDIFILEWRITER_H
+#define MIDIFILEWRITER_H
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "MIDIEvent.h"
+
+/// @brief A writer of Type-1 Standard MIDI Files with a conductor track and one track for each MIDI channel that's used.
+/// @note  Events are timed in pulses, i.e., fractions of a quarter note, from the start of the file, and they must be written
+///        in chronological order. The file is assembled in memory and written to disk by `save`.
+
+class MIDIFileWriter
+{
+public:
+    /// @brief Construct an empty file.
+    /// @param division The number of pulses per quarter note, which must be less than 32768.
+
+    MIDIFileWriter(uint16_t division = DEFAULT_DIVISION);
+
+public:
+    /// @brief Set the tempo of the file.
+    /// @param bpm The tempo in quarter notes per minute.
+
+    void setTempo(double bpm) noexcept;
+
+    /// @brief Set the time signature of the file.
+    /// @param numerator The number of beats per bar.
+    /// @param denominator The length of each beat as a fraction of a whole note, which must be a power of two.
+
+    void setTimeSignature(uint8_t numerator, uint8_t denominator) noexcept;
+
+    /// @brief Set the time at which each of the file's tracks ends, which extends the file past its last event.
+    /// @param time The time in pulses.
+
+    void setLength(uint64_t time) noexcept;
+
+    /// @brief Return the number of pulses per quarter note.
+
+    inline uint16_t getDivision() const noexcept
+    {
+        return division;
+    }
+
+    /// @brief Append the given channel message to the track of its channel.
+    /// @param event The event, whose timestamp is ignored. System messages are not written.
+    /// @param time The time of the event in pulses, which must not precede the time of any event written before.
+
+    void write(const MIDIEvent& event, uint64_t time) noexcept(false);
+
+    /// @brief Write the file to the given path.
+    /// @param path The path of the file to be written.
+    /// @return A Boolean value to indicate whether the file was written successfully or not.
+
+    bool save(const std::string& path) const noexcept;
+
+private:
+    /// @brief The contents of a track and the time of its most recent event.
+
+    struct Track
+    {
+        std::vector<uint8_t> data;
+        uint64_t time = 0;
+    };
+
+    /// @brief Append the time between the given track's most recent event and the given time to the track.
+
+    static void writeDelta(Track& track, uint64_t time) noexcept(false);
+
+    /// @brief Append the given number to the given bytes as a variable-length quantity.
+
+    static void writeVariableLengthQuantity(std::vector<uint8_t>& bytes, uint32_t value) noexcept(false);
+
+    /// @brief Append the given number to the given bytes in big-endian order.
+
+    static void writeInteger(std::vector<uint8_t>& bytes, uint32_t value, size_t size) noexcept(false);
+
+    /// @brief Append a track chunk holding the given track's events to the given bytes.
+
+    void writeTrack(std::vector<uint8_t>& bytes, const Track& track) const noexcept(false);
+
+public:
+    constexpr static uint16_t DEFAULT_DIVISION = 960;
+
+private:
+    /// @brief The greatest time between successive events that can be written as a variable-length quantity.
+
+    constexpr static uint32_t MAXIMUM_DELTA = 0x0FFFFFFF;
+
+private:
+    uint16_t division;
+
+    /// @brief The tempo in microseconds per quarter note.
+
+    uint32_t tempo = 500000;
+
+    uint8_t numerator   = 4;
+    uint8_t denominator = 4;
+
+    uint64_t length = 0;
+
+    std::array<Track, 16> tracks;
+};
+
+#endif
@@ -0,0 +1,256 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef MIDINOTEWHEEL_H
+#define MIDINOTEWHEEL_H
+
+#include "MIDINote.h"
+#include <array>
+#include <cstdint>
+#include <algorithm>
+
+/// @brief A hashed timing wheel of held MIDI notes, where each note is keyed by the absolute tick at which it should be released.
+/// @note  Holding and releasing a note are constant-time operations and a tick on which no notes expire costs nothing beyond one slot lookup.
+///        Notes whose release tick lies more than `Slots` ticks in the future share a slot with earlier notes and remain until their tick arrives.
+
+template <unsigned int Capacity, unsigned int Slots = 64>
+class MIDINoteWheel
+{
+    static_assert((Slots & (Slots - 1)) == 0, "The number of slots must be a power of two.");
+    static_assert(Capacity < UINT16_MAX, "The capacity must be addressable by a 16-bit index.");
+
+public:
+    MIDINoteWheel()
+    {
+        heads.fill(None);
+
+        for (Index k = 0; k < Capacity; ++k)
+        {
+            entries[k].next = k + 1u < Capacity ? k + 1 : None;
+        }
+    }
+
+public:
+    /// @brief Hold the given note until the given tick, provided the wheel is not full.
+    /// @param note The MIDI note to be held.
+    /// @param tick The absolute tick at which the note should be released.
+
+    bool push(const MIDINote & note, uint64_t tick) noexcept
+    {
+        if (full())
+        {
+            return false;
+        }
+
+        const Index k = available;
+        const Index s = slot(tick);
+        available = entries[k].next;
+
+        entries[k].voice.note  = note;
+        entries[k].voice.tick  = tick;
+        entries[k].voice.order = order++;
+        entries[k].next = heads[s];
+        heads[s] = k;
+
+        length = length + 1;
+
+        return true;
+    }
+
+    /// @brief Advance the wheel to the given tick and release each note whose release tick has arrived.
+    /// @param tick The absolute tick that the wheel should advance to.
+    /// @param release A callable object that accepts each released MIDI note.
+
+    template <typename Callback>
+    void advance(uint64_t tick, Callback && release) noexcept
+    {
+        if (tick <= current)
+        {
+            return;
+        }
+
+        const uint64_t steps = std::min<uint64_t>(tick - current, Slots);
+
+        current = tick;
+
+        for (uint64_t k = steps; k > 0; --k)
+        {
+            expire(slot(tick - k + 1), release);
+        }
+    }
+
+    /// @brief Remove the held note that minimises the given key among the held notes that satisfy the given predicate.
+    /// @param key A callable object that maps a `Voice` to a comparable value.
+    /// @param predicate A callable object that indicates whether a `Voice` is a candidate for removal.
+    /// @param note The destination of the removed note.
+    /// @return A Boolean value to indicate whether a note was removed or not.
+    /// @note  This is linear in the number of slots and held notes. It should only be used to steal a voice.
+
+    template <typename Key, typename Predicate>
+    bool popMinimum(Key && key, Predicate && predicate, MIDINote & note) noexcept
+    {
+        Index * link = nullptr;
+
+        for (auto & head : heads)
+        {
+            for (Index * k = &head; *k != None; k = &entries[*k].next)
+            {
+                const Voice & voice = entries[*k].voice;
+
+                if (predicate(voice) && (link == nullptr || key(voice) < key(entries[*link].voice)))
+                {
+                    link = k;
+                }
+            }
+        }
+
+        if (link == nullptr)
+        {
+            return false;
+        }
+
+        note = remove(*link);
+
+        return true;
+    }
+
+    /// @brief Remove the first held note that satisfies the given predicate.
+    /// @param predicate A callable object that indicates whether a `Voice` should be removed.
+    /// @param note The destination of the removed note.
+    /// @return A Boolean value to indicate whether a note was removed or not.
+
+    template <typename Predicate>
+    bool erase(Predicate && predicate, MIDINote & note) noexcept
+    {
+        for (auto & head : heads)
+        {
+            for (Index * k = &head; *k != None; k = &entries[*k].next)
+            {
+                if (predicate(entries[*k].voice))
+                {
+                    note = remove(*k);
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    /// @brief Release every held note.
+    /// @param release A callable object that accepts each released MIDI note.
+
+    template <typename Callback>
+    void clear(Callback && release) noexcept
+    {
+        for (auto & head : heads)
+        {
+            while (head != None)
+            {
+                release(remove(head));
+            }
+        }
+    }
+
+public:
+    /// @brief A held note, the absolute tick at which it should be released, and the order in which it was held.
+
+    struct Voice
+    {
+        MIDINote note;
+        uint64_t tick  = 0;
+        uint64_t order = 0;
+    };
+
+public:
+    /// @brief Compute the number of notes held by the wheel.
+
+    inline int size() const noexcept
+    {
+        return static_cast<int>(length);
+    }
+
+    /// @brief Indicate whether the wheel is full or not.
+
+    inline bool full() const noexcept
+    {
+        return length >= Capacity;
+    }
+
+    /// @brief Indicate whether the wheel is empty or not.
+
+    inline bool empty() const noexcept
+    {
+        return length == 0;
+    }
+
+    /// @brief Indicate whether the wheel holds notes or not.
+
+    inline bool isNotEmpty() const noexcept
+    {
+        return length > 0;
+    }
+
+private:
+    using Index = uint16_t;
+
+    /// @brief Compute the slot that the given tick hashes to.
+
+    inline static Index slot(uint64_t tick) noexcept
+    {
+        return static_cast<Index>(tick & (Slots - 1));
+    }
+
+    /// @brief Release each note in the given slot whose release tick has arrived.
+    /// @param s The index of the slot.
+    /// @param release A callable object that accepts each released MIDI note.
+
+    template <typename Callback>
+    inline void expire(Index s, Callback && release) noexcept
+    {
+        Index * k = &heads[s];
+
+        while (*k != None)
+        {
+            if (entries[*k].voice.tick <= current)
+                release(remove(*k));
+
+            else k = &entries[*k].next;
+        }
+    }
+
+    /// @brief Unlink the entry referenced by the given link and return its note.
+    /// @param link The link, i.e., a slot's head or an entry's successor, that references the entry to be removed.
+
+    inline const MIDINote remove(Index & link) noexcept
+    {
+        const Index k = link;
+        link = entries[k].next;
+        entries[k].next = available;
+        available = k;
+        length = length - 1;
+
+        return entries[k].voice.note;
+    }
+
+private:
+    /// @brief A held note and the index of the next entry in the same list.
+
+    struct Entry
+    {
+        Voice voice;
+        Index next = None;
+    };
+
+    constexpr static Index None = UINT16_MAX;
+
+private:
+    uint64_t current = 0;
+    uint64_t order   = 0;
+    size_t   length  = 0;
+    Index    available = 0;
+    std::array<Index, Slots> heads;
+    std::array<Entry, Capacity> entries;
+};
+
+#endif
@@ -0,0 +1,171 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#include "MIDISender.h"
+#include "ClockTick.h"
+
+MIDISender::MIDISender()
+{
+    midiOut.openPort(0);
+    pending.reserve(MAXIMUM_PENDING_EVENTS);
+    sender = std::thread(&MIDISender::run, this);
+}
+
+MIDISender::~MIDISender()
+{
+    running.store(false);
+    sender.join();
+    midiOut.closePort();
+}
+
+bool MIDISender::enqueue(const MIDIEvent &event) noexcept
+{
+    if (queue.enqueue(event))
+    {
+        return true;
+    }
+
+    dropped.fetch_add(1, std::memory_order_relaxed);
+
+    return false;
+}
+
+MIDISenderMetrics MIDISender::getMetrics() const noexcept
+{
+    MIDISenderMetrics metrics;
+    metrics.queueDepth        = queueDepth.load(std::memory_order_relaxed);
+    metrics.maximumQueueDepth = maximumQueueDepth.load(std::memory_order_relaxed);
+    metrics.latency           = latency.load(std::memory_order_relaxed);
+    metrics.meanLatency       = meanLatency.load(std::memory_order_relaxed);
+    metrics.maximumLatency    = maximumLatency.load(std::memory_order_relaxed);
+    metrics.sent              = sent.load(std::memory_order_relaxed);
+    metrics.dropped           = dropped.load(std::memory_order_relaxed);
+
+    return metrics;
+}
+
+// MARK: - Sender thread
+
+void MIDISender::run() noexcept
+{
+    while (running.load() || queue.isNotEmpty() || !pending.empty())
+    {
+        receive();
+
+        const uint64_t now = ClockTick::now();
+
+        sendDueEvents(now, !running.load());
+
+        uint64_t deadline = now + POLLING_INTERVAL;
+
+        if (!pending.empty())
+        {
+            deadline = std::min(deadline, pending.front().event.timestamp);
+        }
+
+        if (deadline > now)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(deadline - now));
+        }
+    }
+}
+
+void MIDISender::receive() noexcept
+{
+    MIDIEvent event;
+
+    while (pending.size() < pending.capacity() && queue.dequeue(event))
+    {
+        pending.push_back({event, received++});
+        std::push_heap(pending.begin(), pending.end(), std::greater<PendingEvent>());
+    }
+
+    const uint32_t depth = static_cast<uint32_t>(pending.size() + queue.size());
+
+    queueDepth.store(depth, std::memory_order_relaxed);
+
+    if (depth > maximumQueueDepth.load(std::memory_order_relaxed))
+    {
+        maximumQueueDepth.store(depth, std::memory_order_relaxed);
+    }
+}
+
+void MIDISender::sendDueEvents(uint64_t now, bool all) noexcept
+{
+    if (pending.empty() || (!all && pending.front().event.timestamp > now))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(outputMutex);
+
+    while (!pending.empty() && (all || pending.front().event.timestamp <= now))
+    {
+        std::pop_heap(pending.begin(), pending.end(), std::greater<PendingEvent>());
+        const MIDIEvent event = pending.back().event;
+        pending.pop_back();
+
+        if (event.isNoteOn())
+            midiOut.sendNoteOn(event.channel(), event.data1, event.data2);
+
+        else if (event.isNoteOff())
+            midiOut.sendNoteOff(event.channel(), event.data1, event.data2);
+
+        else if (event.size() == 1)
+            midiOut.sendMidiByte(event.status);
+
+        else
+        {
+            std::vector<unsigned char> message {event.status, event.data1, event.data2};
+            midiOut.sendMidiBytes(message);
+        }
+
+        measure(ClockTick::now(), event);
+    }
+}
+
+void MIDISender::measure(uint64_t now, const MIDIEvent &event) noexcept
+{
+    const uint32_t delay = now > event.timestamp ? static_cast<uint32_t>(now - event.timestamp) : 0;
+    const uint32_t mean  = meanLatency.load(std::memory_order_relaxed);
+
+    latency.store(delay, std::memory_order_relaxed);
+    meanLatency.store(mean + (static_cast<int64_t>(delay) - mean) / 16, std::memory_order_relaxed);
+    sent.fetch_add(1, std::memory_order_relaxed);
+
+    if (delay > maximumLatency.load(std::memory_order_relaxed))
+    {
+        maximumLatency.store(delay, std::memory_order_relaxed);
+    }
+}
+
+// MARK: - MIDI port
+
+bool MIDISender::selectPort(unsigned int port) noexcept
+{
+    std::lock_guard<std::mutex> lock(outputMutex);
+
+    if (port == midiOut.getPort())
+        return true;
+
+    if (port >= midiOut.getNumOutPorts())
+        return false;
+
+    midiOut.closePort();
+    return midiOut.openPort(port);
+}
+
+unsigned int MIDISender::getPort() noexcept
+{
+    return midiOut.getPort();
+}
+
+unsigned int MIDISender::getNumberOfPorts() noexcept
+{
+    return midiOut.getNumOutPorts();
+}
+
+std::string MIDISender::getPortDescription() noexcept
+{
+    return midiOut.getName();
+}
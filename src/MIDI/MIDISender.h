@@ -0,0 +1,131 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef MIDISENDER_H
+#define MIDISENDER_H
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "MIDITypes.h"
+#include "SPSCQueue.h"
+#include "ofxMidi.h"
+
+/// @brief A thread that owns a MIDI output port and sends timestamped events when they become due.
+/// @note  Events are passed to the sender through a wait-free queue, so the thread that enqueues them never blocks on the output device.
+///        `enqueue` must only be called by one thread at a time, which is the thread that ticks the sequencer's clock while it ticks,
+///        and the UI thread only while the clock is stopped and its last tick has finished.
+
+class MIDISender
+{
+public:
+     MIDISender();
+    ~MIDISender();
+
+public:
+    /// @brief Add the given event to the queue of events pending dispatch.
+    /// @param event The event to be sent when its timestamp arrives.
+    /// @return A Boolean value to indicate whether the event was enqueued or not.
+
+    bool enqueue(const MIDIEvent & event) noexcept;
+
+    /// @brief Return a snapshot of the sender's metrics.
+
+    MIDISenderMetrics getMetrics() const noexcept;
+
+public:
+    /// @brief Close the current MIDI port and open the given MIDI port.
+    /// @param port The number of the port to be opened.
+    /// @return A Boolean value indicating whether the given port was successfully opened or not.
+
+    bool selectPort(unsigned int port) noexcept;
+
+    /// @brief Return the number of the open MIDI port.
+
+    unsigned int getPort() noexcept;
+
+    /// @brief Return the number of available MIDI output ports.
+
+    unsigned int getNumberOfPorts() noexcept;
+
+    /// @brief Return the open MIDI port's textual description.
+
+    std::string getPortDescription() noexcept;
+
+private:
+    /// @brief Send events when they become due until the sender is destroyed.
+    /// @note  This is the body of the sender thread.
+
+    void run() noexcept;
+
+    /// @brief Move each of the enqueued events into the heap of pending events.
+
+    void receive() noexcept;
+
+    /// @brief Send each of the pending events whose timestamp has arrived.
+    /// @param now The current host time in microseconds.
+    /// @param all Whether every pending event should be sent regardless of its timestamp.
+
+    void sendDueEvents(uint64_t now, bool all) noexcept;
+
+    /// @brief Record the given measurements in the sender's metrics.
+
+    void measure(uint64_t now, const MIDIEvent & event) noexcept;
+
+private:
+    /// @brief An event that's pending dispatch, ordered by its timestamp and then by the order in which it was enqueued.
+
+    struct PendingEvent
+    {
+        MIDIEvent event;
+        uint64_t  order;
+
+        inline bool operator > (const PendingEvent& other) const noexcept
+        {
+            return event.timestamp > other.event.timestamp
+               || (event.timestamp == other.event.timestamp && order > other.order);
+        }
+    };
+
+    /// @brief The maximum number of events that can be waiting to be sent.
+
+    constexpr static size_t MAXIMUM_PENDING_EVENTS = 1024;
+
+    /// @brief The longest time in microseconds that the sender sleeps before checking for new events.
+
+    constexpr static uint64_t POLLING_INTERVAL = 500;
+
+private:
+    ofxMidiOut midiOut;
+    std::mutex outputMutex;
+
+private:
+    /// @brief Events that have been enqueued but not yet received by the sender thread.
+
+    SPSCQueue<MIDIEvent, MAXIMUM_PENDING_EVENTS> queue;
+
+    /// @brief A min-heap of events that have been received by the sender thread, which is owned by the sender thread.
+
+    std::vector<PendingEvent> pending;
+
+    /// @brief The number of events that have been received by the sender thread.
+
+    uint64_t received = 0;
+
+private:
+    std::atomic<uint32_t> queueDepth = {0};
+    std::atomic<uint32_t> maximumQueueDepth = {0};
+    std::atomic<uint32_t> latency = {0};
+    std::atomic<uint32_t> meanLatency = {0};
+    std::atomic<uint32_t> maximumLatency = {0};
+    std::atomic<uint64_t> sent = {0};
+    std::atomic<uint64_t> dropped = {0};
+
+private:
+    std::atomic<bool> running = {true};
+    std::thread sender;
+};
+
+#endif
@@ -5,82 +5,136 @@
 
 MIDIServer::MIDIServer()
 {
-    midiOut.openPort(0);
+    voices.setPolyphony(DEFAULT_POLYPHONY);
 }
 
 MIDIServer::~MIDIServer()
 {
-    midiOut.closePort();
+    
+}
+
+void MIDIServer::setTimestamp(uint64_t timestamp) noexcept
+{
+    this->timestamp = timestamp;
 }
 
 void MIDIServer::broadcast(const MIDINote &note) noexcept
 {
-    if (notes.full())
+    const auto steal = [this](const MIDINote & note)
     {
-        release(notes.pop());
-    }
+        release(note);
+    };
 
-    if (notes.push(note))
+    if (voices.allocate(note, ticks + note.midi.duration, steal))
     {
-        midiOut.sendNoteOn(note.midi.channel, note.note, note.midi.velocity);
+        collect(MIDIEvent::noteOn(note, timestamp));
     }
 }
 
 void MIDIServer::releaseExpiredNotes() noexcept
 {
-    notes.sustain();
-    
-    while (notes.containsExpiredNotes())
+    ticks = ticks + 1;
+
+    voices.advance(ticks, [this](const MIDINote & note)
     {
-        release(notes.pop());
-    }
+        release(note);
+    });
 }
 
 void MIDIServer::releaseAllNotes() noexcept
 {
-    while (notes.isNotEmpty())
+    timestamp = std::max(timestamp, ClockTick::now());
+
+    voices.clear([this](const MIDINote & note)
     {
-        release(notes.pop());
+        release(note);
+    });
+
+    flush();
+}
+
+// MARK: - Dispatch
+
+void MIDIServer::collect(const MIDIEvent &event) noexcept
+{
+    if (batch.isFull())
+    {
+        flush();
     }
+
+    batch.collect(event);
 }
 
+void MIDIServer::flush() noexcept
+{
+    batch.flush([this](const MIDIEvent & event)
+    {
+        sender.enqueue(event);
+    });
+}
+
+// MARK: - MIDI port
+
 int MIDIServer::getPolyphony() noexcept
 {
-    return notes.size();
+    return voices.size();
+}
+
+uint32_t MIDIServer::getVoiceSteals() noexcept
+{
+    return voices.getSteals();
+}
+
+uint32_t MIDIServer::getDroppedNotes() noexcept
+{
+    return voices.getDrops();
+}
+
+MIDISenderMetrics MIDIServer::getSenderMetrics() noexcept
+{
+    return sender.getMetrics();
+}
+
+void MIDIServer::setPolyphony(unsigned int voices) noexcept
+{
+    this->voices.setPolyphony(voices);
+}
+
+void MIDIServer::setChannelPolyphony(uint8_t channel, unsigned int voices) noexcept
+{
+    this->voices.setChannelPolyphony(channel, voices);
+}
+
+void MIDIServer::setVoiceStealingPolicy(VoiceStealing policy) noexcept
+{
+    voices.setStealingPolicy(policy);
 }
 
 bool MIDIServer::selectMIDIPort(unsigned int port) noexcept
 {
-    if (port == midiOut.getPort())
-        return true;
-    
-    if (port >= midiOut.getNumOutPorts())
-        return false;
-    
-    midiOut.closePort();
-    return midiOut.openPort(port);
+    return sender.selectPort(port);
 }
 
 void MIDIServer::selectNextMIDIPort() noexcept
 {
-    const int port  = midiOut.getPort();
-    const int ports = midiOut.getNumOutPorts();
+    const int port  = sender.getPort();
+    const int ports = sender.getNumberOfPorts();
     selectMIDIPort((port + 1) % ports);
 }
 
 void MIDIServer::selectPreviousMIDIPort() noexcept
 {
-    const int port  = midiOut.getPort();
-    const int ports = midiOut.getNumOutPorts();
+    const int port  = sender.getPort();
+    const int ports = sender.getNumberOfPorts();
     selectMIDIPort((port - 1 + ports) % ports);
 }
 
 unsigned int MIDIServer::getMIDIPort() noexcept
 {
-    return midiOut.getPort();
+    return sender.getPort();
 }
 
 std::string MIDIServer::getMIDIPortDescription() noexcept
 {
-    return midiOut.getName();
+    return sender.getPortDescription();
 }
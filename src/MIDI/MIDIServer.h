@@ -4,9 +4,17 @@
 #ifndef MIDISERVER_H
 #define MIDISERVER_H
 
-#include "MIDINoteQueue.h"
+#include <array>
+#include "MIDIVoiceAllocator.h"
+#include "MIDIBatch.h"
+#include "MIDISender.h"
 #include "MIDITypes.h"
-#include "ofxMidi.h"
+#include "ClockTick.h"
+
+/// @brief A server that broadcasts MIDI notes and releases them when they expire.
+/// @note  Messages are not sent immediately. Each message is stamped with the host time of the clock tick
+///        that produced it and sent from a dedicated sender thread when that time arrives.
+///        The messages produced during one tick are collected and handed to the sender thread together by `flush`.
 
 class MIDIServer
 {
@@ -15,12 +23,17 @@ public:
     ~MIDIServer();
 
 public:
+    /// @brief Set the host time at which subsequent messages should be sent.
+    /// @param timestamp The host time in microseconds, which is typically the timestamp of the current clock tick.
+
+    void setTimestamp(uint64_t timestamp) noexcept;
+    
     /// @brief Broadcast the given note.
     /// @param note The MIDI note to broadcast.
 
     void broadcast(const MIDINote& note) noexcept;
     
-    /// @brief Release any expired notes.
+    /// @brief Advance the server by one tick and release any expired notes.
 
     void releaseExpiredNotes() noexcept;
     
@@ -28,11 +41,45 @@ public:
 
     void releaseAllNotes() noexcept;
     
+    /// @brief Hand each of the messages collected since the last flush to the sender thread.
+    /// @note  Identical note on messages with the same timestamp are sent once, and note off messages are sent before
+    ///        note on messages with the same timestamp so that a retriggered note is released before it sounds again.
+
+    void flush() noexcept;
+    
 public:
     /// @brief Return the number of notes currently being broadcast.
 
     int getPolyphony() noexcept;
     
+    /// @brief Return the number of notes that have been released early to make room for new notes.
+
+    uint32_t getVoiceSteals() noexcept;
+    
+    /// @brief Return the number of notes that were not broadcast because no voice was available.
+
+    uint32_t getDroppedNotes() noexcept;
+    
+    /// @brief Return a snapshot of the sender thread's queue depth and send latency.
+
+    MIDISenderMetrics getSenderMetrics() noexcept;
+    
+    /// @brief Set the maximum number of notes that can be broadcast simultaneously across all channels.
+    /// @param voices The desired number of voices.
+
+    void setPolyphony(unsigned int voices) noexcept;
+    
+    /// @brief Set the maximum number of notes that can be broadcast simultaneously on the given channel.
+    /// @param channel The MIDI channel in the range [1, 16].
+    /// @param voices The desired number of voices.
+
+    void setChannelPolyphony(uint8_t channel, unsigned int voices) noexcept;
+    
+    /// @brief Set the policy that determines which note is released when a polyphony limit is reached.
+    /// @param policy The desired voice stealing policy.
+
+    void setVoiceStealingPolicy(VoiceStealing policy) noexcept;
+    
     /// @brief Close the current MIDI port and open the given MIDI port.
     /// @param port The number of the port to be opened.
     /// @return A Boolean value indicating whether the given port was successfully opened or not.
@@ -56,19 +103,45 @@ public:
     std::string getMIDIPortDescription() noexcept;
     
 private:
-    /// @brief Send a note off message for the given MIDI note.
+    /// @brief Schedule a note off message for the given MIDI note.
     /// @param note The note to be released.
 
     inline void release(const MIDINote & note) noexcept
     {
-        midiOut.sendNoteOff(note.midi.channel, note.note, 0);
+        collect(MIDIEvent::noteOff(note, timestamp));
     }
     
+    /// @brief Add the given event to the batch of events produced during the current tick.
+    /// @param event The event to be collected.
+
+    void collect(const MIDIEvent & event) noexcept;
+    
 private:
-    ofxMidiOut midiOut;
+    /// @brief The thread that owns the MIDI output port and sends each message when it becomes due.
+
+    MIDISender sender;
     
 private:
-    MIDINoteQueue<16> notes;
+    /// @brief The number of notes that can be broadcast simultaneously across all channels by default.
+
+    constexpr static unsigned int DEFAULT_POLYPHONY = 16;
+    
+    /// @brief The number of times the server has been advanced, which is the time base of each note's duration.
+
+    uint64_t ticks = 0;
+    
+    /// @brief The allocator of the voices that hold each note until it should be released.
+
+    MIDIVoiceAllocator<512> voices;
+    
+private:
+    /// @brief The host time at which messages should currently be sent.
+
+    uint64_t timestamp = 0;
+    
+    /// @brief The events produced since the last flush.
+
+    MIDIBatch batch;
 };
 
 #endif
@@ -7,5 +7,7 @@
 #include "MIDISettingsValues.h"
 #include "MIDISettings.h"
 #include "MIDINote.h"
+#include "MIDIEvent.h"
+#include "MIDISenderMetrics.h"
 
 #endif
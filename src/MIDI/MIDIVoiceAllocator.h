@@ -0,0 +1,285 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef MIDIVOICEALLOCATOR_H
+#define MIDIVOICEALLOCATOR_H
+
+#include "MIDINoteWheel.h"
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <utility>
+
+/// @brief Constants defining which held note, if any, is released to make room for a new note when a polyphony limit is reached.
+
+enum class VoiceStealing { None, Oldest, Quietest, Shortest };
+
+/// @brief An allocator of MIDI voices that enforces global and per-channel polyphony limits.
+/// @note  Held notes are kept on a timing wheel keyed by the tick at which each should be released.
+///        Whether a (channel, note) pair is held can be determined in constant time.
+///        The limits and the stealing policy can be set from any thread.
+
+template <unsigned int Capacity>
+class MIDIVoiceAllocator
+{
+public:
+    MIDIVoiceAllocator()
+    {
+        voicesPerChannel.fill(0);
+
+        for (auto & limit : channelPolyphony)
+        {
+            limit.store(Capacity);
+        }
+    }
+
+public:
+    /// @brief Set the maximum number of notes that can be held across all channels.
+    /// @param voices The desired number of voices in the range [1, Capacity].
+
+    inline void setPolyphony(unsigned int voices) noexcept
+    {
+        polyphony.store(std::min(std::max(voices, 1u), Capacity));
+    }
+
+    /// @brief Set the maximum number of notes that can be held on the given channel.
+    /// @param channel The MIDI channel in the range [1, 16].
+    /// @param voices The desired number of voices in the range [1, Capacity].
+
+    inline void setChannelPolyphony(uint8_t channel, unsigned int voices) noexcept
+    {
+        if (channel < 1 || channel > CHANNELS)
+        {
+            return;
+        }
+
+        channelPolyphony[channel - 1].store(std::min(std::max(voices, 1u), Capacity));
+    }
+
+    /// @brief Set the policy that determines which note is released when a polyphony limit is reached.
+    /// @param policy The desired voice stealing policy.
+
+    inline void setStealingPolicy(VoiceStealing policy) noexcept
+    {
+        stealing.store(policy);
+    }
+
+public:
+    /// @brief Allocate a voice for the given note, stealing a voice if necessary.
+    /// @param note The MIDI note to be held.
+    /// @param tick The absolute tick at which the note should be released.
+    /// @param release A callable object that accepts each note that's released to make room for the given note.
+    /// @return A Boolean value to indicate whether the note was allocated a voice or not.
+    /// @note  A note that's already held on the same channel is released before it's retriggered.
+
+    template <typename Callback>
+    bool allocate(const MIDINote & note, uint64_t tick, Callback && release) noexcept
+    {
+        const size_t channel = channelIndex(note);
+
+        if (held.test(key(note)))
+        {
+            const auto matches = [&](const Voice & voice)
+            {
+                return key(voice.note) == key(note);
+            };
+
+            retire(matches, release);
+        }
+
+        if (voicesPerChannel[channel] >= channelPolyphony[channel].load(std::memory_order_relaxed))
+        {
+            const auto sameChannel = [&](const Voice & voice)
+            {
+                return channelIndex(voice.note) == channel;
+            };
+
+            if (!steal(sameChannel, release))
+                return drop();
+        }
+
+        if (notes.size() >= static_cast<int>(polyphony.load(std::memory_order_relaxed)) || notes.full())
+        {
+            const auto anyChannel = [](const Voice &)
+            {
+                return true;
+            };
+
+            if (!steal(anyChannel, release))
+                return drop();
+        }
+
+        notes.push(note, tick);
+        held.set(key(note));
+        voicesPerChannel[channel] = voicesPerChannel[channel] + 1;
+
+        return true;
+    }
+
+    /// @brief Advance to the given tick and release each note whose release tick has arrived.
+    /// @param tick The absolute tick to advance to.
+    /// @param release A callable object that accepts each released note.
+
+    template <typename Callback>
+    void advance(uint64_t tick, Callback && release) noexcept
+    {
+        notes.advance(tick, [&](const MIDINote & note)
+        {
+            forget(note);
+            release(note);
+        });
+    }
+
+    /// @brief Release every held note.
+    /// @param release A callable object that accepts each released note.
+
+    template <typename Callback>
+    void clear(Callback && release) noexcept
+    {
+        notes.clear([&](const MIDINote & note)
+        {
+            forget(note);
+            release(note);
+        });
+    }
+
+public:
+    /// @brief Compute the number of notes being held.
+
+    inline int size() const noexcept
+    {
+        return notes.size();
+    }
+
+    /// @brief Return the number of notes that have been released early to make room for new notes.
+    /// @note  This can be called from any thread.
+
+    inline uint32_t getSteals() const noexcept
+    {
+        return steals.load(std::memory_order_relaxed);
+    }
+
+    /// @brief Return the number of notes that could not be allocated a voice.
+    /// @note  This can be called from any thread.
+
+    inline uint32_t getDrops() const noexcept
+    {
+        return drops.load(std::memory_order_relaxed);
+    }
+
+private:
+    using Voice = typename MIDINoteWheel<Capacity>::Voice;
+
+    /// @brief Compute the index of the given note's channel in the range [0, 15].
+
+    inline static size_t channelIndex(const MIDINote & note) noexcept
+    {
+        return (note.midi.channel - 1) & 0x0F;
+    }
+
+    /// @brief Compute the unique index of the given note's (channel, note) pair.
+
+    inline static size_t key(const MIDINote & note) noexcept
+    {
+        return channelIndex(note) * NOTES + (note.note & 0x7F);
+    }
+
+    /// @brief Remove the record of the given note being held.
+
+    inline void forget(const MIDINote & note) noexcept
+    {
+        const size_t channel = channelIndex(note);
+
+        held.reset(key(note));
+        voicesPerChannel[channel] = voicesPerChannel[channel] - 1;
+    }
+
+    /// @brief Release the first held note that satisfies the given predicate.
+
+    template <typename Predicate, typename Callback>
+    inline bool retire(Predicate && predicate, Callback && release) noexcept
+    {
+        MIDINote note;
+
+        if (!notes.erase(predicate, note))
+            return false;
+
+        forget(note);
+        release(note);
+
+        return true;
+    }
+
+    /// @brief Release one of the held notes that satisfy the given predicate according to the stealing policy.
+
+    template <typename Predicate, typename Callback>
+    bool steal(Predicate && predicate, Callback && release) noexcept
+    {
+        MIDINote note;
+        bool stolen = false;
+
+        switch (stealing.load(std::memory_order_relaxed))
+        {
+            case VoiceStealing::None:
+                return false;
+
+            case VoiceStealing::Oldest:
+                stolen = notes.popMinimum([](const Voice & voice) { return voice.order; }, predicate, note);
+                break;
+
+            case VoiceStealing::Quietest:
+                stolen = notes.popMinimum([](const Voice & voice)
+                {
+                    return std::make_pair(voice.note.midi.velocity, voice.order);
+                }, predicate, note);
+                break;
+
+            case VoiceStealing::Shortest:
+                stolen = notes.popMinimum([](const Voice & voice) { return voice.tick; }, predicate, note);
+                break;
+        }
+
+        if (!stolen)
+        {
+            return false;
+        }
+
+        forget(note);
+        release(note);
+        steals.fetch_add(1, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    /// @brief Record that a note could not be allocated a voice.
+
+    inline bool drop() noexcept
+    {
+        drops.fetch_add(1, std::memory_order_relaxed);
+
+        return false;
+    }
+
+private:
+    constexpr static size_t CHANNELS = 16;
+    constexpr static size_t NOTES = 128;
+
+private:
+    MIDINoteWheel<Capacity> notes;
+    std::bitset<CHANNELS * NOTES> held;
+    std::array<unsigned int, CHANNELS> voicesPerChannel;
+
+private:
+    /// @brief The number of notes that have been stolen and dropped, which are written by the thread that allocates voices
+    ///        and read by the UI thread.
+
+    std::atomic<uint32_t> steals = {0};
+    std::atomic<uint32_t> drops  = {0};
+
+private:
+    std::atomic<unsigned int> polyphony = {Capacity};
+    std::atomic<VoiceStealing> stealing = {VoiceStealing::Shortest};
+    std::array<std::atomic<unsigned int>, CHANNELS> channelPolyphony;
+};
+
+#endif
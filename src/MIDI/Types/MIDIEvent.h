@@ -0,0 +1,122 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef MIDIEVENT_H
+#define MIDIEVENT_H
+
+#include <cstdint>
+#include "MIDINote.h"
+
+/// @brief A MIDI message paired with the host time at which it should be sent.
+
+struct MIDIEvent
+{
+    /// @brief The host time in microseconds at which the event should be sent.
+
+    uint64_t timestamp = 0;
+
+    /// @brief The MIDI status byte.
+
+    uint8_t status = 0;
+
+    /// @brief The first MIDI data byte.
+
+    uint8_t data1 = 0;
+
+    /// @brief The second MIDI data byte.
+
+    uint8_t data2 = 0;
+    
+    /// @brief Construct a note on event for the given MIDI note.
+    /// @param note The MIDI note whose note on message should be sent.
+    /// @param timestamp The host time in microseconds at which the event should be sent.
+
+    inline static MIDIEvent noteOn(const MIDINote& note, uint64_t timestamp) noexcept
+    {
+        return {timestamp, channelStatus(NoteOn, note.midi.channel), note.note, note.midi.velocity};
+    }
+    
+    /// @brief Construct a note off event for the given MIDI note.
+    /// @param note The MIDI note whose note off message should be sent.
+    /// @param timestamp The host time in microseconds at which the event should be sent.
+
+    inline static MIDIEvent noteOff(const MIDINote& note, uint64_t timestamp) noexcept
+    {
+        return {timestamp, channelStatus(NoteOff, note.midi.channel), note.note, 0};
+    }
+    
+    /// @brief Construct a system real-time event, such as a MIDI clock pulse or a Start, Continue, or Stop message.
+    /// @param status The status byte of the system real-time message.
+    /// @param timestamp The host time in microseconds at which the event should be sent.
+
+    inline static MIDIEvent realtime(uint8_t status, uint64_t timestamp) noexcept
+    {
+        return {timestamp, status, 0, 0};
+    }
+
+    /// @brief Construct a Song Position Pointer event.
+    /// @param beats The song position in MIDI beats, i.e., sixteenth notes, since the start of the song.
+    /// @param timestamp The host time in microseconds at which the event should be sent.
+
+    inline static MIDIEvent songPosition(uint16_t beats, uint64_t timestamp) noexcept
+    {
+        return {timestamp, SongPosition, static_cast<uint8_t>(beats & 0x7F), static_cast<uint8_t>((beats >> 7) & 0x7F)};
+    }
+
+    /// @brief Indicate whether the event is a note on message.
+
+    inline bool isNoteOn() const noexcept
+    {
+        return (status & 0xF0) == NoteOn;
+    }
+    
+    /// @brief Indicate whether the event is a note off message.
+
+    inline bool isNoteOff() const noexcept
+    {
+        return (status & 0xF0) == NoteOff;
+    }
+    
+    /// @brief Indicate whether the event is a system message, which has no channel.
+
+    inline bool isSystem() const noexcept
+    {
+        return status >= 0xF0;
+    }
+
+    /// @brief Compute the number of bytes in the event's MIDI message.
+
+    inline size_t size() const noexcept
+    {
+        return isSystem() && status != SongPosition ? 1 : 3;
+    }
+
+    /// @brief Return the event's MIDI channel in the range [1, 16].
+
+    inline uint8_t channel() const noexcept
+    {
+        return (status & 0x0F) + 1;
+    }
+    
+public:
+    constexpr static uint8_t TimingClock = 0xF8;
+    constexpr static uint8_t Start    = 0xFA;
+    constexpr static uint8_t Continue = 0xFB;
+    constexpr static uint8_t Stop     = 0xFC;
+    constexpr static uint8_t SongPosition = 0xF2;
+
+private:
+    constexpr static uint8_t NoteOn  = 0x90;
+    constexpr static uint8_t NoteOff = 0x80;
+    
+    /// @brief Compute a channel voice status byte.
+    /// @param type The message type in the upper four bits.
+    /// @param channel The MIDI channel in the range [1, 16].
+
+    inline static uint8_t channelStatus(uint8_t type, uint8_t channel) noexcept
+    {
+        return type | ((channel - 1) & 0x0F);
+    }
+};
+
+#endif
@@ -0,0 +1,43 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef MIDISENDERMETRICS_H
+#define MIDISENDERMETRICS_H
+
+#include <cstdint>
+
+/// @brief Measurements of the MIDI sender thread's workload and timeliness.
+
+struct MIDISenderMetrics
+{
+    /// @brief The number of events waiting to be sent.
+
+    uint32_t queueDepth = 0;
+
+    /// @brief The greatest number of events that have been waiting to be sent at once.
+
+    uint32_t maximumQueueDepth = 0;
+
+    /// @brief The delay in microseconds between the most recently sent event's timestamp and the moment it was sent.
+
+    uint32_t latency = 0;
+
+    /// @brief The mean delay in microseconds between each event's timestamp and the moment it was sent.
+    /// @note  This is an exponential moving average, which favours recent events.
+
+    uint32_t meanLatency = 0;
+
+    /// @brief The greatest delay in microseconds between an event's timestamp and the moment it was sent.
+
+    uint32_t maximumLatency = 0;
+
+    /// @brief The number of events that have been sent.
+
+    uint64_t sent = 0;
+
+    /// @brief The number of events that were discarded because the sender's queue was full.
+
+    uint64_t dropped = 0;
+};
+
+#endif
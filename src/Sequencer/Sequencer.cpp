@@ -2,23 +2,35 @@
 //  Created by David Spry on 20/12/20.
 
 #include "Sequencer.hpp"
+#include "AllocationTrap.h"
+#include <thread>
 
 Sequencer::Sequencer():
 UIComponent(),
-cursor(grid.getGridCellSize())
+cursor(grid.getGridCellSize()),
+subsequence(grid.getGridCellSize()),
+playhead(grid.getGridCellSize())
 {
     initialise();
 }
 
 Sequencer::Sequencer(int x, int y, int width, int height):
 UIComponent(x, y, width, height),
-cursor(grid.getGridCellSize())
+cursor(grid.getGridCellSize()),
+subsequence(grid.getGridCellSize()),
+playhead(grid.getGridCellSize())
 {
     initialise();
 }
 
 Sequencer::~Sequencer()
 {
+    // The clock's thread may still be ticking, so the clock is stopped and its last tick is awaited before the notes that are
+    // still held are released and the members that a tick uses are destroyed. Any later tick is discarded by `tick`.
+
+    clock.setClockShouldTick(false);
+    isEngineAvailable();
+
     midiServer.releaseAllNotes();
 }
 
@@ -26,6 +38,17 @@ void Sequencer::initialise() noexcept
 {
     const int cellSize = grid.getGridCellSize() * 2;
     setMargins(cellSize, cellSize, cellSize, 0);
+
+    for (const auto type : {X, Y, Diagonal, Alternating, Random})
+        redirects.emplace_back(grid.getGridCellSize(), type);
+
+    portals.emplace_back(grid.getGridCellSize(), false);
+    portals.emplace_back(grid.getGridCellSize(), true);
+
+    stateDescription.cycleLength   = 0;
+    stateDescription.activePattern = 0;
+    stateDescription.queuedPattern = 0;
+
     updateCursorStateDescription();
     updateMIDIStateDescription();
     clock.connect(this);
@@ -35,6 +58,57 @@ void Sequencer::initialise() noexcept
 
 void Sequencer::draw()
 {
+    if (isEngineAvailable())
+    {
+        publishSnapshot();
+    }
+
+    const bool isNew = snapshots.update();
+    const EngineSnapshot & snapshot = snapshots.getReadBuffer();
+
+    // The description of the cursor's cell is derived from the first snapshot that reflects both the latest edits and the cursor's position.
+
+    if (isNew)
+    {
+        const bool isStale = snapshot.revision != describedRevision || !(snapshot.focus == describedFocus);
+
+        if (isStale && snapshot.focus == cursor.xy)
+        {
+            updateCursorStateDescription();
+        }
+
+        if (snapshot.cycleLength != stateDescription.cycleLength)
+        {
+            stateDescription.cycleLength = snapshot.cycleLength;
+            stateDescription.setContainsNewData();
+        }
+
+        // The playheads of a pattern that has just become active are counted from its first snapshot, and any selection is dropped,
+        // since the selection referred to the previous pattern's playheads.
+
+        if (snapshot.pattern != displayedPattern)
+        {
+            displayedPattern      = snapshot.pattern;
+            numberOfPlayheads     = snapshot.playheads.size();
+            isSelectingPlayheads  = false;
+            selectedPlayheadIndex = 0;
+
+            stateDescription.activePattern = snapshot.pattern;
+            updateCursorStateDescription();
+
+            bank.release();
+        }
+    }
+
+    const size_t queued = bank.getQueuedIndex();
+    const size_t queuedPattern = queued == SequencerBank::None ? stateDescription.activePattern : queued;
+
+    if (queuedPattern != stateDescription.queuedPattern)
+    {
+        stateDescription.queuedPattern = queuedPattern;
+        stateDescription.setContainsNewData();
+    }
+
     ofClear(colours->backgroundColour);
 
     grid.draw();
@@ -42,11 +116,7 @@ void Sequencer::draw()
     ofPushMatrix();
     ofTranslate(origin.x + margins.l, origin.y + margins.t);
     
-    for (auto & node : table)
-        node->draw();
-
-    for (auto & node : playheads)
-        node.draw();
+    drawSnapshot(snapshot);
 
     ofPopMatrix();
     
@@ -55,6 +125,32 @@ void Sequencer::draw()
     drawSubsequenceIfRequested();
 }
 
+void Sequencer::drawSnapshot(const EngineSnapshot& snapshot) noexcept
+{
+    for (size_t k = 0; k < snapshot.nodes.size(); ++k)
+    {
+        const EngineNode & node = snapshot.nodes[k];
+        SQNode * view = nullptr;
+
+        switch (node.type)
+        {
+            case Redirect:    { view = &redirects[node.redirect.redirection]; break; }
+            case Portal:      { view = &portals[node.portal.paired]; break; }
+            case Subsequence: { view = &subsequence; break; }
+            default: continue;
+        }
+
+        view->present(snapshot.positions[k], node);
+        view->draw();
+    }
+
+    for (const auto & state : snapshot.playheads)
+    {
+        playhead.present(state);
+        playhead.draw();
+    }
+}
+
 void Sequencer::drawSubsequenceIfRequested() noexcept
 {
     if (!isViewingSubsequence)
@@ -62,7 +158,14 @@ void Sequencer::drawSubsequenceIfRequested() noexcept
         return;
     }
 
-    if (!table.contains(cursor.xy.x, cursor.xy.y))
+    const EngineSnapshot & snapshot = snapshots.getReadBuffer();
+
+    if (!(snapshot.focus == cursor.xy))
+    {
+        return;
+    }
+
+    if (!snapshot.hasFocusNode || snapshot.focusNode.type != Subsequence)
     {
         isViewingSubsequence = false;
         
@@ -72,13 +175,8 @@ void Sequencer::drawSubsequenceIfRequested() noexcept
     ofSetColor(colours->backgroundColour, 175);
     ofDrawRectangle(origin.x, origin.y, size.w, size.h);
 
-    const auto node = table.get(cursor.xy.x, cursor.xy.y)->get();
-    const auto type = node->nodeType;
-
-    if (type == Subsequence)
-    {
-        static_cast<SQSubsequence&>(*node).drawSequence(centre);
-    }
+    subsequence.presentSequence(snapshot.focusSubsequence);
+    subsequence.drawSequence(centre);
 }
 
 // MARK: - UIComponent callbacks
@@ -138,51 +236,280 @@ void Sequencer::setMargins(const int top, const int left, const int right, const
 
 void Sequencer::toggleClock() noexcept
 {
-    clock.toggleClock();
+    // The MIDI server's queue has a single producer, so the notes that are still held are released by the UI thread
+    // only while the clock's thread is idle, i.e., before the clock starts or once its last tick has finished.
 
-    midiServer.releaseAllNotes();
+    if (!clock.clockIsTicking())
+    {
+        midiServer.releaseAllNotes();
+        clock.toggleClock();
+    }
+
+    else
+    {
+        clock.toggleClock();
+
+        if (isEngineAvailable())
+        {
+            midiServer.releaseAllNotes();
+            applyPendingCommands();
+        }
+    }
     
     updateMIDIStateDescription();
 }
 
-void Sequencer::tick()
+bool Sequencer::renderToMIDIFile(const std::string& path, uint64_t bars, double tempo) noexcept
 {
-    midiServer.releaseExpiredNotes();
+    if (!isEngineAvailable())
+    {
+        return false;
+    }
 
-    const auto dimensions = grid.getGridDimensions();
+    applyPendingCommands();
 
-    const auto interact = [&](SQPlayhead & playhead) -> bool
+    try
     {
-        if (table.contains(playhead.xy.x, playhead.xy.y))
-        {
-            const auto & xy = playhead.xy;
-            const auto node = table.get(xy.x, xy.y)->get();
-            const auto type = node->nodeType;
-            node->interact(playhead, midiServer, dimensions);
-            return type == Subsequence;
-        }
+        SequencerEngine copy(bank.getActive());
+        SequencerRenderer renderer;
+        renderer.setTempo(tempo);
+        renderer.setTicksPerBeat(std::max(clock.getSubdivision(), 1));
+
+        return renderer.render(copy, bars, path);
+    }
+
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+// MARK: - Transport
+
+bool Sequencer::seek(uint64_t tick) noexcept
+{
+    if (!isEngineAvailable())
+    {
+        return false;
+    }
+
+    applyPendingCommands();
+
+    SequencerEngine & engine = bank.getActive();
+
+    const uint64_t position = bank.getTransportTick();
+
+    if (tick < position)
+    {
+        return false;
+    }
+
+    engine.seek(tick - position);
+
+    publishSnapshot();
+
+    return true;
+}
+
+// MARK: - Projects
+
+bool Sequencer::saveProject(const std::string& path) noexcept
+{
+    if (!isEngineAvailable())
+    {
+        return false;
+    }
+
+    applyPendingCommands();
 
+    return SequencerProject::save(bank.getActive(), path);
+}
+
+bool Sequencer::loadProject(const std::string& path) noexcept
+{
+    if (!isEngineAvailable())
+    {
         return false;
-    };
+    }
+
+    applyPendingCommands();
 
-    for (auto & playhead : playheads)
+    SequencerEngine & engine = bank.getActive();
+
+    if (!SequencerProject::load(engine, path))
     {
-        const UIPoint<int> originalPosition = playhead.xy;
+        return false;
+    }
+
+    // The transport is moved to the project's position, from which the other patterns' switches are quantised.
+
+    bank.setTransportTick(engine.getPosition());
+
+    numberOfPlayheads     = engine.getPlayheads().size();
+    isSelectingPlayheads  = false;
+    selectedPlayheadIndex = 0;
+
+    gridDimensionsDidUpdate();
 
-        playhead.update(dimensions);
+    publishSnapshot();
+    updateCursorStateDescription();
 
-        if (interact(playhead)) continue;
+    return true;
+}
 
-        if (playhead.xy == originalPosition)
-            playhead.update(dimensions);
+// MARK: - Patterns
 
-        for (size_t k = 0; k < 4; ++k)
+bool Sequencer::loadPattern(size_t index, const std::string& path) noexcept
+{
+    if (index == bank.getActiveIndex())
+    {
+        return loadProject(path);
+    }
+
+    try
+    {
+        SequencerEngine * pattern = bank.getPattern(index);
+
+        return pattern != nullptr && SequencerProject::load(*pattern, path);
+    }
+
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+bool Sequencer::queuePattern(size_t index, Quantisation quantisation) noexcept
+{
+    try
+    {
+        SequencerEngine * pattern = bank.getPattern(index);
+
+        if (pattern == nullptr)
         {
-            if (interact(playhead)) break;
+            return false;
         }
+
+        // The pattern is fitted to the grid and its upcoming ticks are simulated while it's still owned by the UI thread,
+        // so the clock's thread can dispatch its first tick as soon as it becomes active.
+
+        pattern->reserveLookahead();
+
+        const UISize<int>& dimensions = grid.getGridDimensions();
+
+        if (pattern->getGridSize().w != dimensions.w || pattern->getGridSize().h != dimensions.h)
+        {
+            SequencerCommand command;
+            command.type = SequencerCommand::Resize;
+            command.xy   = {dimensions.w, dimensions.h};
+
+            pattern->apply(command);
+        }
+
+        pattern->simulate(lookaheadTicks.load(std::memory_order_relaxed));
     }
-    
-    updateMIDIStateDescription();
+
+    catch (const std::exception &)
+    {
+        return false;
+    }
+
+    const uint32_t beat    = static_cast<uint32_t>(std::max(clock.getSubdivision(), 1));
+    const uint32_t quantum = quantisation == Quantisation::Bar ? beat * beatsPerBar : beat;
+
+    if (!bank.queue(index, quantum))
+    {
+        return false;
+    }
+
+    if (isEngineAvailable())
+    {
+        bank.commit();
+    }
+
+    // A pattern that was queued before, or that was active before an immediate switch, is no longer playable.
+
+    bank.release();
+
+    return true;
+}
+
+void Sequencer::tick(const ClockTick& tick)
+{
+    // A tick that arrives after the clock has been stopped is discarded, since the UI thread may already own the engine.
+    // Both flags are sequentially consistent, so either this tick sees that the clock has stopped or the UI thread waits for it.
+
+    isTicking.store(true);
+
+    if (!clock.clockIsTicking())
+    {
+        isTicking.store(false);
+        return;
+    }
+
+    const AllocationTrap trap;
+
+    applyPendingCommands();
+
+    // A queued pattern becomes active at the start of the tick that begins its beat or bar, after the edits made to the
+    // previous pattern have been applied, and the whole tick is played by the same pattern.
+
+    bank.advance();
+
+    SequencerEngine & engine = bank.getActive();
+
+    engine.simulate(1);
+
+    midiServer.setTimestamp(tick.timestamp);
+    midiServer.releaseExpiredNotes();
+
+    // Notes scheduled between ticks are placed by the clock's nominal tick length.
+
+    const uint64_t tempo  = std::max(clock.getTempo() * clock.getSubdivision(), 1);
+    const uint64_t length = 60000000 / tempo;
+
+    engine.dispatch([&](const MIDINote & note, uint16_t offset)
+    {
+        midiServer.setTimestamp(tick.timestamp + offset * length / EnginePlayhead::TICK_RESOLUTION);
+        midiServer.broadcast(note);
+    });
+
+    midiServer.flush();
+
+    // The upcoming ticks are simulated after the current tick's messages have been handed to the sender,
+    // so the cost of the simulation is never added to the latency of the current tick.
+
+    engine.simulate(lookaheadTicks.load(std::memory_order_relaxed));
+
+    publishSnapshot();
+
+    updateMIDIActivityStateDescription();
+
+    isTicking.store(false, std::memory_order_release);
+}
+
+// MARK: - Snapshots
+
+void Sequencer::publishSnapshot() noexcept
+{
+    if (!snapshots.isConsumed())
+    {
+        return;
+    }
+
+    if (isApplyingCommands.test_and_set(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    EngineSnapshot & snapshot = snapshots.getWriteBuffer();
+
+    bank.getActive().snapshot(snapshot, getFocus());
+    snapshot.tick    = bank.getTransportTick();
+    snapshot.pattern = bank.getActiveIndex();
+    snapshots.publish();
+
+    isApplyingCommands.clear(std::memory_order_release);
 }
 
 // MARK: - Sequencer cursor
@@ -228,15 +555,10 @@ void Sequencer::moveCursor(Direction direction) noexcept
         return;
     }
 
-    else if (table.contains(cursor.xy.x, cursor.xy.y))
+    else
     {
-        const auto node = table.get(cursor.xy.x, cursor.xy.y)->get();
-        const auto type = node->nodeType;
-        if (type == Subsequence)
-        {
-            static_cast<SQSubsequence&>(*(node)).moveCursor(direction);
-            updateCursorStateDescription();
-        }
+        subsequence.moveCursor(direction);
+        updateCursorStateDescription();
     }
 }
 
@@ -263,23 +585,50 @@ void Sequencer::updateCursorStateDescription() noexcept
     stateDescription.cursorChannel  = cursor.getMIDISettings().channel;
     stateDescription.cursorVelocity = cursor.getMIDISettings().velocity;
 
-    if (table.contains(cursor.xy.x, cursor.xy.y))
-    {
-        const auto node = table.get(cursor.xy.x, cursor.xy.y)->get();
-        stateDescription.cursorHoverDescription = node->describe();
-    }
+    setFocus(cursor.xy);
 
-    else
+    // The cursor's cell is described by the latest snapshot if the snapshot describes it in full.
+    // Otherwise, the description is updated when the engine publishes a snapshot that describes the cursor's cell.
+
+    const EngineSnapshot & snapshot = snapshots.getReadBuffer();
+
+    if (snapshot.focus == cursor.xy)
     {
-        stateDescription.cursorHoverDescription.clear();
+        describedRevision = snapshot.revision;
+        describedFocus    = snapshot.focus;
+
+        if (!snapshot.hasFocusNode)
+            stateDescription.cursorHoverDescription.clear();
+
+        else switch (snapshot.focusNode.type)
+        {
+            case Redirect:    { stateDescription.cursorHoverDescription = SQRedirect::describe(snapshot.focusNode); break; }
+            case Portal:      { stateDescription.cursorHoverDescription = SQPortal::describe(snapshot.focusNode); break; }
+            case Subsequence: { stateDescription.cursorHoverDescription = SQSubsequence::describe(snapshot.focusSubsequence); break; }
+            default:          { stateDescription.cursorHoverDescription.clear(); break; }
+        }
     }
 
     stateDescription.setContainsNewData();
 }
 
+void Sequencer::updateMIDIActivityStateDescription() noexcept
+{
+    const MIDISenderMetrics metrics = midiServer.getSenderMetrics();
+
+    stateDescription.midiPolyphony    = midiServer.getPolyphony();
+    stateDescription.midiVoiceSteals  = midiServer.getVoiceSteals();
+    stateDescription.midiDroppedNotes = midiServer.getDroppedNotes();
+    stateDescription.midiQueueDepth   = metrics.queueDepth;
+    stateDescription.midiSendLatency  = metrics.meanLatency;
+    stateDescription.setContainsNewData();
+}
+
 void Sequencer::updateMIDIStateDescription() noexcept
 {
     stateDescription.midiPolyphony          = midiServer.getPolyphony();
+    stateDescription.midiVoiceSteals        = midiServer.getVoiceSteals();
+    stateDescription.midiDroppedNotes       = midiServer.getDroppedNotes();
     stateDescription.midiPortNumberIn       = clock.getMIDIPort();
     stateDescription.midiPortNumberOut      = midiServer.getMIDIPort();
     stateDescription.midiPortDescriptionIn  = clock.getMIDIPortDescription();
@@ -296,149 +645,161 @@ void Sequencer::expandSubsequence() noexcept
         return;
     }
     
-    else if (table.contains(cursor.xy.x, cursor.xy.y))
-    {
-        const auto node = table.get(cursor.xy.x, cursor.xy.y)->get();
-        const auto type = node->nodeType;
-        isViewingSubsequence = type == Subsequence;
-    }
+    const EngineSnapshot & snapshot = snapshots.getReadBuffer();
+
+    isViewingSubsequence = snapshot.focus == cursor.xy
+                        && snapshot.hasFocusNode
+                        && snapshot.focusNode.type == Subsequence;
 }
 
-bool Sequencer::placeNote(uint8_t noteIndex) noexcept(false)
+bool Sequencer::placeNote(uint8_t noteIndex) noexcept
 {
     const UIPoint<int>& xy = cursor.getGridPosition();
 
-    if (table.contains(xy.x, xy.y))
-    {
-        if (!isViewingSubsequence)
-            return false;
+    SequencerCommand command;
+    command.type  = SequencerCommand::PlaceNote;
+    command.xy    = xy;
+    command.note  = {noteIndex, cursor.getMIDISettings()};
+    command.flag  = isViewingSubsequence;
+    command.index = subsequence.getCursorIndex();
 
-        const auto node = table.get(xy.x, xy.y);
-        const auto type = node->get()->nodeType;
-        
-        if (type == Subsequence)
-        {
-            auto& subsequence = static_cast<SQSubsequence&>(*(node->get()));
-            const bool result = subsequence.placeNote(noteIndex, cursor.getMIDISettings());
-            updateCursorStateDescription();
-            return result;
-        }
-    }
-
-    const MIDINote note = {noteIndex, cursor.getMIDISettings()};
-    std::shared_ptr<SQNode> node = std::make_shared<SQSubsequence>(grid.getGridCellSize(), xy, note);
-    table.set(std::move(node), xy.x, xy.y);
-    updateCursorStateDescription();
-
-    return true;
+    return submit(std::move(command));
 }
 
-bool Sequencer::placePortal() noexcept(false)
+bool Sequencer::placePortal() noexcept
 {
     const UIPoint<int>& xy = cursor.getGridPosition();
-    
-    if (table.contains(xy.x, xy.y)) return false;
-    
-    if (!unpairedPortals.empty())
-    {
-        SQPortal* pair = unpairedPortals.back();
-        SQPortal* node = new SQPortal(grid.getGridCellSize(), xy, pair->getPairPortalType());
-        
-        node->pairWith(pair);
-        pair->pairWith(node);
-        unpairedPortals.pop_back();
-
-        table.set(std::shared_ptr<SQPortal>(node), xy.x, xy.y);
-    }
-
-    else
-    {
-        SQPortal* node = new SQPortal(grid.getGridCellSize(), xy, PortalType::A);
-        unpairedPortals.push_back(node);
-        table.set(std::shared_ptr<SQPortal>(node), xy.x, xy.y);
-    }
 
-    updateCursorStateDescription();
+    SequencerCommand command;
+    command.type = SequencerCommand::PlacePortal;
+    command.xy   = xy;
 
-    return true;
+    return submit(std::move(command));
 }
 
 void Sequencer::placePlayhead(Direction direction) noexcept
 {
+    if (numberOfPlayheads >= MAXIMUM_PLAYHEADS) return;
+
     const int dx = direction == Direction::E ? 1 : direction == Direction::W ? -1 : 0;
     const int dy = direction == Direction::S ? 1 : direction == Direction::N ? -1 : 0;
     const UIPoint<int>& xy = cursor.getGridPosition();
 
-    playheads.emplace_back(grid.getGridCellSize(), xy, dx, dy);
+    SequencerCommand command;
+    command.type  = SequencerCommand::PlacePlayhead;
+    command.xy    = xy;
+    command.delta = {dx, dy};
+
+    if (submit(std::move(command)))
+    {
+        numberOfPlayheads = numberOfPlayheads + 1;
+    }
 }
 
-bool Sequencer::placeRedirect(Redirection type) noexcept(false)
+bool Sequencer::placeRedirect(Redirection type) noexcept
 {
     const UIPoint<int>& xy = cursor.getGridPosition();
 
-    if (table.contains(xy.x, xy.y)) return false;
-    
-    SQRedirect* node = new SQRedirect(grid.getGridCellSize(), xy, type);
-
-    table.set(std::shared_ptr<SQNode>(node), xy.x, xy.y);
-    
-    updateCursorStateDescription();
+    SequencerCommand command;
+    command.type        = SequencerCommand::PlaceNode;
+    command.xy          = xy;
+    command.redirection = type;
 
-    return true;
+    return submit(std::move(command));
 }
 
-void Sequencer::eraseFromCurrentPosition() noexcept(false)
+void Sequencer::eraseFromCurrentPosition() noexcept
 {
     if (isSelectingPlayheads) return eraseSelectedPlayhead();
 
-    const UIPoint<int>& xy = cursor.getGridPosition();
+    SequencerCommand command;
+    command.type  = SequencerCommand::Erase;
+    command.xy    = cursor.getGridPosition();
+    command.flag  = isViewingSubsequence;
+    command.index = subsequence.getCursorIndex();
+
+    submit(std::move(command));
+}
 
-    if (!table.contains(xy.x, xy.y)) return;
+void Sequencer::setRandomSeed(uint64_t seed) noexcept
+{
+    SequencerCommand command;
+    command.type = SequencerCommand::SetSeed;
+    command.seed = seed;
 
-    const auto node = table.get(xy.x, xy.y)->get();
-    const auto type = node->nodeType;
-    
-    if (isViewingSubsequence)
+    submit(std::move(command));
+}
+
+void Sequencer::gridDimensionsDidUpdate() noexcept
+{
+    const UISize<int>& dimensions = grid.getGridDimensions();
+
+    // The engine keeps its current size if the grid can't be resized to fit the window.
+
+    if (dimensions.w <= 0 || dimensions.h <= 0
+     || dimensions.w > SequencerEngine::MAXIMUM_GRID_SIZE || dimensions.h > SequencerEngine::MAXIMUM_GRID_SIZE)
     {
-        auto & sequence = static_cast<SQSubsequence&>(*node);
-        sequence.eraseFromCurrentPosition();
-        updateCursorStateDescription();
         return;
     }
-    
-    if (type == Portal)
+
+    SequencerCommand command;
+    command.type = SequencerCommand::Resize;
+    command.xy   = {dimensions.w, dimensions.h};
+
+    submit(std::move(command));
+}
+
+// MARK: - Sequencer commands
+
+bool Sequencer::submit(SequencerCommand&& command) noexcept
+{
+    const bool submitted = commands.enqueue(std::move(command));
+
+    if (isEngineAvailable())
     {
-        const auto & portal = static_cast<SQPortal&>(*node);
+        applyPendingCommands();
+    }
+    
+    return submitted;
+}
 
-        if (portal.isPaired())
-        {
-            unpairedPortals.push_back(portal.getPair());
-        }
+bool Sequencer::isEngineAvailable() noexcept
+{
+    if (clock.clockIsTicking())
+    {
+        return false;
+    }
 
-        else
-        {
-            auto &nodes = unpairedPortals;
-            auto remove = std::remove(nodes.begin(), nodes.end(), node);
-            nodes.erase(remove, nodes.end());
-        }
+    while (isTicking.load())
+    {
+        std::this_thread::yield();
     }
 
-    table.erase(xy.x, xy.y);
-    updateCursorStateDescription();
+    return true;
 }
 
-void Sequencer::gridDimensionsDidUpdate() noexcept(false)
+void Sequencer::applyPendingCommands() noexcept
 {
-    const UISize<int>& dimensions = grid.getGridDimensions();
+    if (isApplyingCommands.test_and_set(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    SequencerCommand command;
 
-    table.setSize(dimensions.h, dimensions.w);
+    while (commands.dequeue(command))
+    {
+        bank.getActive().apply(command);
+    }
+    
+    isApplyingCommands.clear(std::memory_order_release);
 }
 
 // MARK: - Playhead controls
 
 void Sequencer::toggleSelectPlayheadsMode() noexcept
 {
-    isSelectingPlayheads = !isSelectingPlayheads && !playheads.empty();
+    isSelectingPlayheads = !isSelectingPlayheads && numberOfPlayheads > 0;
     
     if (isSelectingPlayheads)
     {
@@ -446,10 +807,10 @@ void Sequencer::toggleSelectPlayheadsMode() noexcept
         selectNextPlayhead();
     }
 
-    else if (!playheads.empty())
+    else if (numberOfPlayheads > 0)
     {
-        selectedPlayheadIndex = selectedPlayheadIndex % playheads.size();
-        playheads.at(selectedPlayheadIndex).setIsSelected(false);
+        selectedPlayheadIndex = selectedPlayheadIndex % numberOfPlayheads;
+        setPlayheadIsSelected(selectedPlayheadIndex, false);
     }
 }
 
@@ -457,38 +818,78 @@ void Sequencer::toggleSelectedPlayhead() noexcept
 {
     if (!isSelectingPlayheads) return;
 
-    auto& playhead = playheads.at(selectedPlayheadIndex);
-    bool isEnabled = playhead.getIsEnabled();
+    SequencerCommand command;
+    command.type  = SequencerCommand::TogglePlayhead;
+    command.index = selectedPlayheadIndex;
 
-    playhead.setIsEnabled(!isEnabled);
+    submit(std::move(command));
 }
 
 void Sequencer::selectPlayheadSuccessor(bool next) noexcept
 {
-    if (playheads.empty()) return;
+    if (numberOfPlayheads == 0) return;
     
-    auto const size = playheads.size();
+    auto const size = numberOfPlayheads;
 
     isSelectingPlayheads = true;
 
     selectedPlayheadIndex = selectedPlayheadIndex % size;
 
-    playheads.at(selectedPlayheadIndex).setIsSelected(false);
+    setPlayheadIsSelected(selectedPlayheadIndex, false);
 
     selectedPlayheadIndex += (next ? 1 : (int) size - 1);
     selectedPlayheadIndex %= size;
 
-    playheads.at(selectedPlayheadIndex).setIsSelected(true);
+    setPlayheadIsSelected(selectedPlayheadIndex, true);
+}
+
+void Sequencer::setSelectedPlayheadRate(uint8_t multiplier, uint8_t divider) noexcept
+{
+    if (!isSelectingPlayheads) return;
+
+    SequencerCommand command;
+    command.type  = SequencerCommand::SetPlayheadRate;
+    command.index = selectedPlayheadIndex;
+    command.xy    = {multiplier, divider};
+
+    submit(std::move(command));
+}
+
+void Sequencer::cycleSelectedPlayheadRate(bool multiplier) noexcept
+{
+    if (!isSelectingPlayheads) return;
+
+    SequencerCommand command;
+    command.type  = SequencerCommand::CyclePlayheadRate;
+    command.index = selectedPlayheadIndex;
+    command.flag  = multiplier;
+
+    submit(std::move(command));
+}
+
+void Sequencer::setPlayheadIsSelected(int index, bool isSelected) noexcept
+{
+    SequencerCommand command;
+    command.type  = SequencerCommand::SelectPlayhead;
+    command.index = index;
+    command.flag  = isSelected;
+
+    submit(std::move(command));
 }
 
 void Sequencer::eraseSelectedPlayhead() noexcept
 {
     if (!isSelectingPlayheads) return;
 
-    auto &nodes = playheads;
-    auto remove = nodes.erase(nodes.begin() + selectedPlayheadIndex);
+    SequencerCommand command;
+    command.type  = SequencerCommand::ErasePlayhead;
+    command.index = selectedPlayheadIndex;
+
+    if (!submit(std::move(command))) return;
+
+    numberOfPlayheads = numberOfPlayheads - 1;
 
-    if (playheads.empty())
+    if (numberOfPlayheads == 0)
          return toggleSelectPlayheadsMode();
     else return selectPreviousPlayhead();
 }
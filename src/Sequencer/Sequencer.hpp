@@ -7,8 +7,17 @@
 #include "Ensemble.h"
 #include "DotGrid.h"
 #include "Cursor.h"
+#include "TripleBuffer.h"
+#include "SequencerBank.hpp"
+#include "SequencerProject.hpp"
+#include "SequencerRenderer.hpp"
 #include "SequencerStateDescription.hpp"
 
+/// @brief The Ensemble sequencer, which connects the sequencer engine to the user, the clock, and the MIDI output.
+/// @note  Edits are submitted to the engine as commands, and the engine's state is drawn from the snapshots it writes,
+///        so the UI never touches the engine while the clock's thread owns it. The engine is the active pattern of a bank
+///        of preloaded patterns, which can be switched at the next beat or bar while the clock ticks.
+
 class Sequencer: public UIComponent, public ClockListener
 {
 public:
@@ -63,13 +72,25 @@ public:
     
 public:
     /// @brief The callback that's executed when the sequencer's clock ticks.
+    /// @param tick A description of the moment at which the tick should be realised.
 
-    void tick() override;
+    void tick(const ClockTick& tick) override;
     
     /// @brief Toggle the sequencer's clock.
 
     void toggleClock() noexcept;
     
+    /// @brief Set the number of ticks that should be simulated ahead of the clock.
+    /// @param ticks The desired number of ticks in the range [0, 16].
+    /// @note  The notes of each tick are computed ahead of time and broadcast when the tick arrives, so the cost of simulating
+    ///        the sequencer's contents doesn't delay the MIDI output of the current tick. Edits made within the window are
+    ///        applied from the tick that follows them by re-simulating the affected ticks.
+
+    inline void setLookahead(unsigned int ticks) noexcept
+    {
+        lookaheadTicks.store(std::min<size_t>(ticks, SequencerLookahead::MAXIMUM_LOOKAHEAD));
+    }
+    
 
 public:
     /// @brief Return a textual description of the sequencer's contents at the cursor's current position.
@@ -79,6 +100,128 @@ public:
         return stateDescription;
     }
 
+// MARK: - MIDI output
+
+public:
+    /// @brief Set the maximum number of notes that can be broadcast simultaneously across all channels.
+    /// @param voices The desired number of voices.
+
+    inline void setPolyphony(unsigned int voices) noexcept
+    {
+        midiServer.setPolyphony(voices);
+    }
+    
+    /// @brief Set the maximum number of notes that can be broadcast simultaneously on the given channel.
+    /// @param channel The MIDI channel in the range [1, 16].
+    /// @param voices The desired number of voices.
+
+    inline void setChannelPolyphony(uint8_t channel, unsigned int voices) noexcept
+    {
+        midiServer.setChannelPolyphony(channel, voices);
+    }
+    
+    /// @brief Set the policy that determines which note is released when a polyphony limit is reached.
+    /// @param policy The desired voice stealing policy.
+
+    inline void setVoiceStealingPolicy(VoiceStealing policy) noexcept
+    {
+        midiServer.setVoiceStealingPolicy(policy);
+    }
+
+    /// @brief Render the given number of bars from the current position of the sequencer to a Standard MIDI File without the clock.
+    /// @param path The path of the file to be written.
+    /// @param bars The number of bars to be rendered.
+    /// @param tempo The tempo of the render in beats per minute.
+    /// @return A Boolean value to indicate whether the file was written successfully or not.
+    /// @note  The clock must be stopped, since the engine is owned by the clock's thread while it ticks. The render advances a copy
+    ///        of the engine, so playback is unaffected.
+
+    bool renderToMIDIFile(const std::string& path, uint64_t bars, double tempo) noexcept;
+
+// MARK: - Transport
+
+public:
+    /// @brief Advance the sequencer to the given position without broadcasting any notes, e.g., to line it up with a song position.
+    /// @param tick The transport's position in clock ticks, e.g., a bar's index multiplied by the number of beats per bar and
+    ///        the clock's subdivision.
+    /// @return A Boolean value to indicate whether the sequencer reached the given position or not.
+    /// @note  The clock must be stopped, and positions before the sequencer's current position can't be reached, since the
+    ///        sequencer's state can't be reversed.
+
+    bool seek(uint64_t tick) noexcept;
+
+    /// @brief Return the transport's position in clock ticks, which every pattern shares, as of the most recent snapshot.
+
+    inline uint64_t getPosition() const noexcept
+    {
+        return snapshots.getReadBuffer().tick;
+    }
+
+// MARK: - Projects
+
+public:
+    /// @brief Save the contents of the sequencer and its live state to a project file.
+    /// @param path The path of the file to be written.
+    /// @return A Boolean value to indicate whether the file was written successfully or not.
+    /// @note  The clock must be stopped, since the engine is owned by the clock's thread while it ticks.
+
+    bool saveProject(const std::string& path) noexcept;
+
+    /// @brief Replace the contents of the sequencer and its live state with the project at the given path.
+    /// @param path The path of the project.
+    /// @return A Boolean value to indicate whether the project was loaded successfully or not.
+    /// @note  The clock must be stopped. The grid is resized to fit the window once the project has been loaded.
+
+    bool loadProject(const std::string& path) noexcept;
+
+// MARK: - Patterns
+
+public:
+    /// @brief Constants defining the boundaries at which a queued pattern can become active.
+
+    enum class Quantisation { Beat, Bar };
+
+    /// @brief Load the project at the given path into the given pattern of the sequencer's bank.
+    /// @param index The index of the pattern in the range [0, SequencerBank::MAXIMUM_PATTERNS).
+    /// @param path The path of the project.
+    /// @return A Boolean value to indicate whether the project was loaded successfully or not.
+    /// @note  A pattern that's queued can't be loaded. Loading the active pattern is equivalent to `loadProject`.
+
+    bool loadPattern(size_t index, const std::string& path) noexcept;
+
+    /// @brief Switch to the given pattern at the first tick of the next beat or bar, replacing any switch that's already queued.
+    /// @param index The index of the pattern in the range [0, SequencerBank::MAXIMUM_PATTERNS), which is empty if nothing
+    ///        has been loaded into it.
+    /// @param quantisation The boundary at which the pattern should become active.
+    /// @return A Boolean value to indicate whether the switch was queued or not.
+    /// @note  The pattern is prepared to play before it's queued, so the clock's thread only has to swap it in. If the clock is
+    ///        stopped, the pattern becomes active immediately.
+
+    bool queuePattern(size_t index, Quantisation quantisation) noexcept;
+
+    /// @brief Cancel the queued pattern switch, if any.
+
+    inline void cancelQueuedPattern() noexcept
+    {
+        bank.cancel();
+        bank.release();
+    }
+
+    /// @brief Return the index of the active pattern.
+
+    inline size_t getActivePattern() const noexcept
+    {
+        return bank.getActiveIndex();
+    }
+
+    /// @brief Set the number of beats per bar, which determines where bars begin when a switch is quantised to the next bar.
+    /// @param beats The number of beats per bar.
+
+    inline void setBeatsPerBar(uint8_t beats) noexcept
+    {
+        beatsPerBar = std::max<uint8_t>(beats, 1);
+    }
+
 // MARK: - Sequencer cursor
 
 public:
@@ -121,23 +264,20 @@ public:
 public:
     /// @brief Place a new note at the sequencer cursor's current position.
     /// @param noteIndex A number in the range [0, 11] representing a note from the chromatic scale, beginning with C.
-    /// @return A Boolean value to indicate whether the note was placed successfully or not.
-    /// @throw An exception will be thrown in the case where the given position is out of range.
+    /// @return A Boolean value to indicate whether the edit was submitted successfully or not.
 
-    bool placeNote(uint8_t noteIndex) noexcept(false);
+    bool placeNote(uint8_t noteIndex) noexcept;
     
     /// @brief Place a new portal node at the sequencer cursor's current position.
-    /// @return A Boolean value to indicate whether the node was placed successfully or not.
-    /// @throw An exception will be thrown in the case where the given position is out of range.
+    /// @return A Boolean value to indicate whether the edit was submitted successfully or not.
     
-    bool placePortal() noexcept(false);
+    bool placePortal() noexcept;
     
     /// @brief Place a new redirect node at the sequencer cursor's current position.
     /// @param type The desired type of redirect node to place.
-    /// @return A Boolean value to indicate whether the node was placed successfully or not.
-    /// @throw An exception will be thrown in the case where the given position is out of range.
+    /// @return A Boolean value to indicate whether the edit was submitted successfully or not.
 
-    bool placeRedirect(Redirection type) noexcept(false);
+    bool placeRedirect(Redirection type) noexcept;
     
     /// @brief Place a new playhead at the sequencer cursor's current position.
     /// @param direction The desired direction of the playhead node.
@@ -145,13 +285,17 @@ public:
     void placePlayhead(Direction direction) noexcept;
 
     /// @brief Erase the contents of the sequencer at the sequencer cursor's current position.
-    /// @throw An exception will be thrown in the case where the given position is out of range.
 
-    void eraseFromCurrentPosition() noexcept(false);
+    void eraseFromCurrentPosition() noexcept;
     
     /// @brief Expand and view the subsequence at the sequencer cursor's current position.
 
     void expandSubsequence() noexcept;
+
+    /// @brief Set the seed from which the choices of Random redirects are derived, so that playback can be reproduced.
+    /// @param seed The project's seed.
+
+    void setRandomSeed(uint64_t seed) noexcept;
     
 // MARK: - Playhead selection
 public:
@@ -177,16 +321,101 @@ public:
         selectPlayheadSuccessor(false);
     }
     
+    /// @brief Set the rate at which the selected playhead moves relative to the clock's tick rate.
+    /// @param multiplier The number of moves per `divider` ticks in the range [1, 8].
+    /// @param divider The number of ticks per `multiplier` moves in the range [1, 8].
+
+    void setSelectedPlayheadRate(uint8_t multiplier, uint8_t divider) noexcept;
+    
+    /// @brief Increment the multiplier of the selected playhead's rate, wrapping from 8 to 1.
+    
+    inline void cycleSelectedPlayheadMultiplier() noexcept
+    {
+        cycleSelectedPlayheadRate(true);
+    }
+    
+    /// @brief Increment the divider of the selected playhead's rate, wrapping from 8 to 1.
+
+    inline void cycleSelectedPlayheadDivider() noexcept
+    {
+        cycleSelectedPlayheadRate(false);
+    }
+    
 private:
     /// @brief Select the successor playhead.
     /// @param next Whether the next playhead or the previous playhead should be selected.
 
     void selectPlayheadSuccessor(bool next) noexcept;
     
+    /// @brief Select or deselect the playhead with the given index.
+    /// @param index The index of the playhead.
+    /// @param isSelected Whether the playhead should be selected or not.
+
+    void setPlayheadIsSelected(int index, bool isSelected) noexcept;
+    
     /// @brief Erase the selected playhead.
     /// @note  The sequencer must be in playhead selection mode.
     
     void eraseSelectedPlayhead() noexcept;
+    
+    /// @brief Increment the multiplier or the divider of the selected playhead's rate.
+    /// @param multiplier Whether the multiplier or the divider should be incremented.
+
+    void cycleSelectedPlayheadRate(bool multiplier) noexcept;
+
+// MARK: - Snapshots
+
+private:
+    /// @brief Write a snapshot of the engine's state if the UI has read the previous snapshot.
+    /// @note  This should be called by the thread that owns the engine's state.
+
+    void publishSnapshot() noexcept;
+    
+    /// @brief Draw the nodes and playheads of the given snapshot.
+    /// @param snapshot The snapshot to be drawn.
+
+    void drawSnapshot(const EngineSnapshot& snapshot) noexcept;
+
+    /// @brief Set the cell whose contents should be described in full by the engine's snapshots.
+    /// @param xy The position of the cell.
+
+    inline void setFocus(const UIPoint<int>& xy) noexcept
+    {
+        const uint64_t x = static_cast<uint32_t>(xy.x);
+        const uint64_t y = static_cast<uint32_t>(xy.y);
+
+        focus.store(x << 32 | y, std::memory_order_relaxed);
+    }
+
+    /// @brief Return the cell whose contents should be described in full by the engine's snapshots.
+
+    inline UIPoint<int> getFocus() const noexcept
+    {
+        const uint64_t xy = focus.load(std::memory_order_relaxed);
+
+        return {static_cast<int>(xy >> 32), static_cast<int>(xy & 0xFFFFFFFF)};
+    }
+
+// MARK: - Sequencer commands
+
+private:
+    /// @brief Indicate whether the UI thread can use the sequencer's engine and MIDI server, i.e., whether the clock is stopped,
+    ///        waiting for the clock's thread to finish any tick that began before the clock was stopped.
+    /// @note  This should be called by the UI thread.
+
+    bool isEngineAvailable() noexcept;
+
+    /// @brief Submit an edit to the thread that owns the sequencer's state.
+    /// @param command The edit to be submitted.
+    /// @return A Boolean value to indicate whether the edit was submitted or not.
+    /// @note  Edits are applied immediately if the clock is not ticking.
+
+    bool submit(SequencerCommand&& command) noexcept;
+    
+    /// @brief Apply each of the pending edits to the sequencer's engine.
+    /// @note  This should be called by the thread that owns the engine's state.
+
+    void applyPendingCommands() noexcept;
 
 // MARK: - Private functions
 
@@ -197,7 +426,7 @@ private:
     
     /// @brief Update the underlying data structures to reflect a change in the size of the sequencer grid.
 
-    void gridDimensionsDidUpdate() noexcept(false);
+    void gridDimensionsDidUpdate() noexcept;
     
     /// @brief Update the contents of the sequencer's state description object to reflect a change in the sequencer's cursor.
 
@@ -207,6 +436,11 @@ private:
     
     void updateMIDIStateDescription() noexcept;
     
+    /// @brief Update the MIDI polyphony and MIDI output metrics of the sequencer's state description object.
+    /// @note  Unlike `updateMIDIStateDescription`, this does not allocate memory and it can be called from the clock's thread.
+
+    void updateMIDIActivityStateDescription() noexcept;
+    
     /// @brief Draw the subsequence at the cursor's current position if the user has requested to view an expanded subsequence.
 
     void drawSubsequenceIfRequested() noexcept;
@@ -244,12 +478,80 @@ private:
     /// @brief The index of the currently selected playhead node.
 
     int selectedPlayheadIndex = 0;
+    
+    /// @brief The number of playheads on the sequencer, as seen by the UI thread.
+
+    size_t numberOfPlayheads = 0;
+
+private:
+    /// @brief A queue of edits that are pending application to the sequencer's engine.
+
+    SPSCQueue<SequencerCommand, 64> commands;
+    
+    /// @brief A flag that's held by the thread applying edits to the sequencer's engine or writing a snapshot of its state.
+
+    std::atomic_flag isApplyingCommands = ATOMIC_FLAG_INIT;
+
+    /// @brief Whether the clock's thread is processing a tick, which the UI thread waits on before it takes the engine after
+    ///        the clock has been stopped.
+
+    std::atomic<bool> isTicking = {false};
 
 private:
-    std::vector<SQPlayhead> playheads;
-    std::vector<SQPortal *> unpairedPortals;
-    using NodePtr = std::shared_ptr<SQNode>;
-    Table<NodePtr> table;
+    /// @brief The sequencer's patterns, the active one of which holds the sequencer's contents and the simulation that moves its playheads.
+
+    SequencerBank bank;
+
+    /// @brief The number of beats per bar by which pattern switches are quantised, as seen by the UI thread.
+
+    uint8_t beatsPerBar = 4;
+
+    /// @brief The pattern of the most recent snapshot drawn by the UI thread.
+
+    size_t displayedPattern = 0;
+    
+    /// @brief The number of ticks that should be simulated ahead of the clock.
+
+    std::atomic<size_t> lookaheadTicks = {DEFAULT_LOOKAHEAD};
+
+    /// @brief Snapshots of the engine's state, which are written by the thread that owns the engine and read by the UI thread.
+
+    TripleBuffer<EngineSnapshot> snapshots = {SequencerEngine::MAXIMUM_NODES, SequencerEngine::MAXIMUM_PLAYHEADS};
+    
+    /// @brief The cell whose contents should be described in full by the engine's snapshots, packed as two 32-bit coordinates.
+
+    std::atomic<uint64_t> focus = {0};
+    
+    /// @brief The revision and the focus of the snapshot from which the cursor's state description was last updated.
+
+    uint64_t describedRevision = 0;
+    UIPoint<int> describedFocus;
+
+private:
+    /// @brief The nodes that draw the redirects of each redirection type.
+
+    std::vector<SQRedirect> redirects;
+    
+    /// @brief The nodes that draw the unpaired portals and the paired portals, respectively.
+
+    std::vector<SQPortal> portals;
+    
+    /// @brief The node that draws subsequences and the expanded subsequence.
+
+    SQSubsequence subsequence;
+    
+    /// @brief The node that draws playheads.
+
+    SQPlayhead playhead;
+
+private:
+    /// @brief The maximum number of playheads that can be placed on the sequencer.
+
+    constexpr static size_t MAXIMUM_PLAYHEADS = SequencerEngine::MAXIMUM_PLAYHEADS;
+    
+    /// @brief The number of ticks that are simulated ahead of the clock by default.
+
+    constexpr static size_t DEFAULT_LOOKAHEAD = 2;
 };
 
 #endif
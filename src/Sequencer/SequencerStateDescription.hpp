@@ -14,7 +14,35 @@ typedef struct SequencerStateDescription
 {
     /// @brief The number of notes being output currently.
 
-    uint8_t midiPolyphony;
+    uint16_t midiPolyphony;
+    
+    /// @brief The number of notes that have been released early to make room for new notes.
+
+    uint32_t midiVoiceSteals;
+    
+    /// @brief The number of notes that were not output because no voice was available.
+
+    uint32_t midiDroppedNotes;
+    
+    /// @brief The number of MIDI messages waiting to be sent by the MIDI server's sender thread.
+
+    uint32_t midiQueueDepth;
+    
+    /// @brief The mean delay in microseconds between the moment each MIDI message was due and the moment it was sent.
+
+    uint32_t midiSendLatency;
+
+    /// @brief The number of clock ticks after which the sequencer's music repeats itself exactly, or zero if it hasn't repeated yet.
+
+    uint64_t cycleLength;
+
+    /// @brief The index of the sequencer's active pattern.
+
+    size_t activePattern;
+
+    /// @brief The index of the pattern that will become active at the next beat or bar, which equals `activePattern` if no switch is queued.
+
+    size_t queuedPattern;
 
     /// @brief The port number of the MIDI server's input port (where clock ticks are received).
     
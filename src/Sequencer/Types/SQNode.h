@@ -6,14 +6,12 @@
 
 #include "Label.h"
 #include "GridCell.h"
-#include "MIDIServer.h"
+#include "EngineTypes.h"
 #include "ofxRisographColours.hpp"
 
-/// @brief Constants defining nodes that can be placed on the Ensemble sequencer.
-
-enum  SQNodeType { Redirect, Playhead, Portal, Note, Subsequence };
-
-/// @brief A node that can be placed on the Ensemble sequencer.
+/// @brief A node that can be drawn on the Ensemble sequencer.
+/// @note  Nodes are drawn from the records of the sequencer engine's snapshots. A node draws any number of records by presenting
+///        each record in turn, so the UI holds one node for each appearance rather than one node for each cell of the grid.
 
 class SQNode: public GridCell
 {
@@ -23,104 +21,58 @@ public:
     {
         text.setSize(cellSize, cellSize);
     }
-    
+
     SQNode(unsigned int cellSize, const UIPoint<int>& position, SQNodeType type):
     GridCell(cellSize, position), nodeType(type)
     {
         text.setSize(cellSize, cellSize);
     }
-    
+
 public:
     /// @brief Draw the node at its position on the sequencer.
 
     void draw() override
     {
-        const int x = origin.x + margins.l + screenPosition.x;
-        const int y = origin.y + margins.t + screenPosition.y;
-        
-        if (shouldRedraw)
-        {
-            path.clear();
-            path.circle(centre.x, centre.y, static_cast<int>(0.40f * size.w));
-            shouldRedraw = false;
-        }
-
-        path.draw(x, y);
+        drawAtScreenPosition(screenPosition);
     }
     
-    /// @brief Interact with the given node.
-    /// @param node The node that should be interacted with.
-    /// @param server The sequencer's MIDI server.
-    /// @param gridSize The dimensions of the grid in rows and columns.
-
-    virtual void interact(SQNode& node, MIDIServer& server, const UISize<int>& gridSize) noexcept = 0;
+    /// @brief Move the node to the given position and adopt the appearance of the given record.
+    /// @param xy The position of the record as column and row indices.
+    /// @param node The record to be drawn.
 
-    /// @brief Provide a textual description of the node.
-    
-    virtual std::string describe() noexcept = 0;
-    
-    /// @brief Determine whether the node is enabled or not.
-
-    inline bool getIsEnabled() const noexcept
+    virtual void present(const UIPoint<int>& xy, const EngineNode& node) noexcept
     {
-        return isEnabled;
+        moveToGridPosition(xy);
     }
     
-    /// @brief Set a flag to indicate whether the node should move or not.
-    /// @param nodeShouldMove A flag indicating whether the node should move or not.
+public:
+    /// @brief The node's type.
 
-    inline void setIsEnabled(bool nodeShouldMove) noexcept
-    {
-        isEnabled = nodeShouldMove;
-    }
+    SQNodeType nodeType;
     
-    /// @brief Select or deselect the node.
-    /// @param nodeIsSelected A flag indicating whether the node is selected or not.
-
-    inline void setIsSelected(bool nodeIsSelected) noexcept
-    {
-        isSelected = nodeIsSelected;
-    }
-
-    /// @brief Update the node's position on the sequencer.
-    /// @param gridSize The dimensions of the sequencer grid in rows and columns.
+protected:
+    /// @brief Draw the node at the given screen position.
+    /// @param position The screen position relative to the origin point and margins.
 
-    inline void update(const UISize<int>& gridSize)
+    inline void drawAtScreenPosition(const UIPoint<int>& position)
     {
-        xy.x = (xy.x + delta.x + gridSize.w) % gridSize.w;
-        xy.y = (xy.y + delta.y + gridSize.h) % gridSize.h;
+        const int x = origin.x + margins.l + position.x;
+        const int y = origin.y + margins.t + position.y;
         
-        moveToGridPosition(xy);
-    }
-    
-    /// @brief Get the node's direction of movement.
-    
-    inline const UIVector<int>& getDirection() const noexcept
-    {
-        return delta;
+        if (shouldRedraw)
+        {
+            path.clear();
+            path.circle(centre.x, centre.y, static_cast<int>(0.40f * size.w));
+            shouldRedraw = false;
+        }
+
+        path.draw(x, y);
     }
-    
-public:
-    /// @brief The node's direction.
-    
-    UIVector<int> delta;
-    
-    /// @brief The node's type.
 
-    SQNodeType nodeType;
-    
 protected:
     /// @brief The node's text label.
 
     Label text;
-    
-    /// @brief A flag to indicate whether the node should move or not (if the node would otherwise move).
-    
-    bool isEnabled = true;
-    
-    /// @brief A flag to indicate whether the node is currently selected by the user or not.
-
-    bool isSelected = false;
 };
 
 #endif
@@ -7,7 +7,7 @@
 #include "SQNode.h"
 #include "MIDITypes.h"
 
-/// @brief A node representing a MIDI note on the sequencer.
+/// @brief A node representing a MIDI note, which is drawn in an expanded subsequence.
 
 class SQNote: public SQNode
 {
@@ -48,31 +48,26 @@ public:
         SQNode::draw();
     }
     
-    /// @brief Broadcast the SQNode's underlying MIDI note using the sequencer's MIDI server.
-    /// @param node The node that's interacting with the SQNote.
-    /// @param server The sequencer's MIDI server.
-    /// @param gridSize The dimensions of the sequencer's grid in rows and columns.
+    /// @brief Provide a textual description of the note and its MIDI settings.
 
-    void interact(SQNode& node, MIDIServer& server, const UISize<int>& gridSize) noexcept override
+    inline std::string describe() noexcept
     {
-        if (node.getIsEnabled())
-        {
-            server.broadcast(note);
-        }
+        return note.description();
     }
     
-    inline std::string describe() noexcept override
+    /// @brief Return the underlying MIDI note.
+
+    inline const MIDINote& getMIDINote() const noexcept
     {
-        return note.description();
+        return note;
     }
     
-    /// @brief Modify the underlying MIDI note.
-    /// @param noteIndex A number in the range [0, 11] representing a note from the chromatic scale, beginning with C.
-    /// @param midiSettings The MIDI settings that the note should use.
+    /// @brief Replace the underlying MIDI note.
+    /// @param midiNote The MIDI note that should replace the underlying MIDI note.
 
-    void modify(uint8_t noteIndex, MIDISettings settings) noexcept
+    inline void setMIDINote(const MIDINote& midiNote) noexcept
     {
-        note.set(noteIndex, settings);
+        note = midiNote;
     }
     
     /// @brief Pass the given note's notename into the given stream.
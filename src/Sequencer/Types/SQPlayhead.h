@@ -7,6 +7,7 @@
 #include "SQNode.h"
 
 /// @brief A playhead node that moves on the sequencer and broadcasts information.
+/// @note  The playhead's state belongs to the sequencer engine. See `EnginePlayhead`.
 
 class SQPlayhead: public SQNode
 {
@@ -14,19 +15,7 @@ public:
     SQPlayhead(unsigned int cellSize):
     SQNode(cellSize, Playhead)
     {
-        delta.set(0, 1);
-    }
-    
-    SQPlayhead(unsigned int cellSize, const UIPoint<int>& position):
-    SQNode(cellSize, position, Playhead)
-    {
-        delta.set(0, 1);
-    }
-    
-    SQPlayhead(unsigned int cellSize, const UIPoint<int>& position, int deltaX, int deltaY):
-    SQNode(cellSize, position, Playhead)
-    {
-        delta.set(deltaX, deltaY);
+        
     }
 
 public:
@@ -40,15 +29,25 @@ public:
         SQNode::draw();
     }
     
-    void interact(SQNode& node, MIDIServer& server, const UISize<int>& gridSize) noexcept override
+    /// @brief Move the node to the position of the given playhead and adopt the playhead's appearance.
+    /// @param playhead The playhead to be drawn.
+
+    inline void present(const EnginePlayhead& playhead) noexcept
     {
-        
+        moveToGridPosition(playhead.xy);
+
+        isEnabled  = playhead.enabled;
+        isSelected = playhead.selected;
     }
+
+private:
+    /// @brief Whether the playhead being drawn is enabled or not.
+
+    bool isEnabled = true;
     
-    inline std::string describe() noexcept override
-    {
-        return "";
-    }
+    /// @brief Whether the playhead being drawn is selected by the user or not.
+
+    bool isSelected = false;
 };
 
 #endif
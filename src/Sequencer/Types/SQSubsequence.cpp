@@ -12,106 +12,46 @@ void SQSubsequence::drawSequence(UIPoint<int> & centre)
     ofTranslate(x, y);
 
     grid.draw();
-    for (auto & node : sequence)
-        node.draw();
+    for (size_t k = 0; k < length; ++k)
+        sequence[k].draw();
 
     ofPopMatrix();
 }
 
-std::string SQSubsequence::describe() noexcept
+void SQSubsequence::presentSequence(const EngineSubsequence& subsequence) noexcept
 {
-    std::stringstream stringstream;
+    length = std::min<size_t>(subsequence.length, sequence.size());
 
-    const auto & a = std::begin(sequence);
-    const auto & b = std::end(sequence);
-    const auto iterator = std::ostream_iterator<SQNote>(stringstream, "-");
-
-    std::copy(a, b, iterator);
-    std::string string = stringstream.str();
-
-    string.pop_back();
-
-    return string;
-}
-
-void SQSubsequence::interact(SQNode& node, MIDIServer& server, const UISize<int>& gridSize) noexcept
-{
-    if (sequence.empty())
+    for (size_t k = 0; k < length; ++k)
     {
-        return;
+        sequence[k].setMIDINote(subsequence.notes[k]);
     }
 
-    index = index % sequence.size();
-    auto & note = sequence.at(index);
-    grid.setCurrentSequenceIndex(index);
-    note.interact(node, server, gridSize);
-
-    index = index + 1;
-    index = index % sequence.size();
-}
-
-void SQSubsequence::moveCursor(Direction direction) noexcept
-{
-    grid.moveCursor(direction);
-}
-
-bool SQSubsequence::placeNote(uint8_t noteIndex, MIDISettings midiSettings) noexcept
-{
-    const auto size = grid.getGridDimensions();
-    const int index = grid.getCursorPosition().y * size.w
-                    + grid.getCursorPosition().x;
+    grid.setNumberOfVisibleCells(static_cast<int>(length));
 
-    if (grid.getCursorPosition().x >= size.w ||
-        grid.getCursorPosition().y >= size.h)
-        return false;
+    // The subsequence's index refers to the note that will be broadcast next, so the note that was broadcast last is highlighted.
 
-    if (index < sequence.size())
+    if (length > 0)
     {
-        sequence.at(index).modify(noteIndex, midiSettings);
-        return true;
+        grid.setCurrentSequenceIndex(static_cast<unsigned int>((subsequence.index + length - 1) % length));
     }
-
-    const UIPoint<int> xy =
-    {
-        index % size.w,
-        index / size.w
-    };
-
-    MIDINote const note (noteIndex, midiSettings);
-    sequence.emplace_back(grid.getGridCellSize(), xy, note);
-    grid.increaseNumberOfVisibleCells();
-
-    return true;
 }
 
-void SQSubsequence::eraseFromCurrentPosition() noexcept
+std::string SQSubsequence::describe(const EngineSubsequence& subsequence) noexcept
 {
-    const int length = static_cast<int>(sequence.size());
-    const int cursor = grid.getCursorPosition().y
-                     * grid.getGridDimensions().w
-                     + grid.getCursorPosition().x;
-
-    if (length <= 1 || cursor == length) return;
+    std::string string;
 
-    const auto decrementPosition = [&](SQNode & node)
+    for (size_t k = 0; k < subsequence.length; ++k)
     {
-        const UIPoint<int> & xy = node.xy;
-        const UISize <int> & dimensions = grid.getGridDimensions();
-        const int n = xy.y * dimensions.w + xy.x;
-        const int row = (n - 1) / dimensions.w;
-        const int col = (n - 1) % dimensions.w;
-        node.moveToGridPosition(row, col);
-    };
+        if (k > 0) string += "-";
 
-    for (size_t k = cursor + 1; k < length; ++k)
-    {
-        auto & node = sequence.at(k);
-        decrementPosition(node);
+        string += subsequence.notes[k].notename();
     }
-    
-    sequence.erase(sequence.begin() + cursor);
-    
-    index = index % sequence.size();
 
-    grid.decreaseNumberOfVisibleCells();
+    return string;
+}
+
+void SQSubsequence::moveCursor(Direction direction) noexcept
+{
+    grid.moveCursor(direction);
 }
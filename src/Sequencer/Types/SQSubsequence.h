@@ -10,6 +10,9 @@
 #include "SequenceGrid.h"
 
 /// @brief A node representing an sequence of MIDI notes.
+/// @note  The subsequence's notes belong to the sequencer engine. An SQSubsequence draws subsequences on the grid, and it draws
+///        the notes of one subsequence when the user expands it, along with the cursor with which the user edits the subsequence.
+///        A note is constructed for every cell of the subsequence's grid up front so that presenting a subsequence never allocates memory.
 
 class SQSubsequence: public SQNode
 {
@@ -20,38 +23,21 @@ public:
         initialise();
     }
 
-    SQSubsequence(unsigned int cellSize, const UIPoint<int>& position):
-    SQNode(cellSize, position, Subsequence)
-    {
-        initialise();
-    }
-
-    SQSubsequence(unsigned int cellSize, const UIPoint<int>& position, MIDINote midiNote):
-    SQNode(cellSize, position, Subsequence)
-    {
-        initialise();
-        
-        sequence.emplace_back(grid.getGridCellSize(), midiNote);
-        
-        grid.increaseNumberOfVisibleCells();
-    }
-
 public:
     /// @brief Draw the full subsequence at the given position.
     /// @param centre The desired centre point at which to draw the sequence.
 
     void drawSequence(UIPoint<int> & centre);
 
-    /// @brief Combine each note's description into one description string.
+    /// @brief Adopt the notes of the given subsequence so that it can be drawn in full.
+    /// @param subsequence The subsequence to be drawn.
 
-    std::string describe() noexcept override;
+    void presentSequence(const EngineSubsequence& subsequence) noexcept;
 
-    /// @brief Move to the next position within the subsequence and broadcast from the current position.
-    /// @param node The node that's interacting with the SQSubsequence.
-    /// @param server The sequencer's MIDI server.
-    /// @param gridSize The dimensions of the sequencer's grid in rows and columns.
+    /// @brief Combine the description of each of the given subsequence's notes into one description string.
+    /// @param subsequence The subsequence to be described.
 
-    void interact(SQNode& node, MIDIServer& server, const UISize<int>& gridSize) noexcept override;
+    static std::string describe(const EngineSubsequence& subsequence) noexcept;
 
 public:
     /// @brief Move the subsequence's cursor in the given direction.
@@ -59,28 +45,39 @@ public:
 
     void moveCursor(Direction direction) noexcept;
     
-    /// @brief Place a note at the subsequence's cursor's current position.
-    /// @param noteIndex A number in the range [0, 11] representing a note from the chromatic scale, beginning with C.
-    /// @param midiSettings The MIDI settings that the note should use.
+    /// @brief Return the index of the note at the subsequence's cursor's current position.
 
-    bool placeNote(uint8_t noteIndex, MIDISettings midiSettings) noexcept;
-
-    /// @brief Erase from the subsequence at the subsequence's cursor's current position.
+    inline int getCursorIndex() const noexcept
+    {
+        const auto size = grid.getGridDimensions();
 
-    void eraseFromCurrentPosition() noexcept;
+        return grid.getCursorPosition().y * size.w + grid.getCursorPosition().x;
+    }
     
 private:
     /// @brief Initialise the subsequence and its members.
 
     inline void initialise() noexcept
     {
-        sequence.reserve(16);
+        const auto size = grid.getGridDimensions();
+        const int capacity = size.w * size.h;
+
+        sequence.reserve(capacity);
+
+        for (int k = 0; k < capacity; ++k)
+        {
+            const UIPoint<int> xy = {k % size.w, k / size.w};
+            sequence.emplace_back(grid.getGridCellSize(), xy);
+        }
+
         grid.setCurrentSequenceIndex(0);
         path.setColor(colours->secondaryForegroundColour);
     }
 
 private:
-    uint8_t index = 0;
+    /// @brief The number of notes in the presented subsequence, which occupy the leading elements of `sequence`.
+
+    size_t length = 0;
 
 private:
     std::vector<SQNote> sequence;
@@ -52,19 +52,33 @@ void InformationWindow::updateLabelsContents() noexcept
 
         polyphony.setText(computePolyphonyString(8, stateDescription->midiPolyphony));
 
+        state.clear();
+        state.append("Loop: ");
+        state.append(stateDescription->cycleLength > 0 ? std::to_string(stateDescription->cycleLength) : "-");
+        cycleLength.setText(state);
+
+        state.clear();
+        state.append("Pattern: ");
+        state.append(std::to_string(stateDescription->activePattern + 1));
+
+        if (stateDescription->queuedPattern != stateDescription->activePattern)
+            state.append(" > " + std::to_string(stateDescription->queuedPattern + 1));
+
+        pattern.setText(state);
+
         stateDescription->setDataWasConsumed();
         
         setShouldRedraw();
     }
 }
 
-const std::string InformationWindow::computePolyphonyString(uint8_t width, uint8_t polyphony) const noexcept
+const std::string InformationWindow::computePolyphonyString(uint8_t width, uint16_t polyphony) const noexcept
 {
     std::string string;
     std::pair<int, int> rows;
 
-    rows.first  = std::min(polyphony, width);
-    rows.second = polyphony - rows.first;
+    rows.first  = std::min<int>(polyphony, width);
+    rows.second = std::min<int>(polyphony - rows.first, width);
     
     string.append(rows.first, '|');
     string.append(width - rows.first, '.');
@@ -94,6 +108,14 @@ void InformationWindow::layoutChildComponents() noexcept
     polyphony.setShouldFillBackground(true);
     polyphony.setPositionWithOrigin(size.w - polyphony.getSize().w - margins.r, 15);
 
+    cycleLength.shrinkToFitText();
+    cycleLength.setShouldFillBackground(true);
+    cycleLength.setPositionWithOrigin(size.w - cycleLength.getSize().w - margins.r, 15 + polyphony.getSize().h);
+
+    pattern.shrinkToFitText();
+    pattern.setShouldFillBackground(true);
+    pattern.setPositionWithOrigin(size.w - pattern.getSize().w - margins.r, 15 + polyphony.getSize().h + cycleLength.getSize().h);
+
     midiOutPort.shrinkToFitText();
     midiOutPort.setShouldFillBackground(true);
     midiOutPort.setPositionWithOrigin(size.w - midiOutPort.getSize().w - margins.r,
@@ -73,6 +73,8 @@ private:
     {
         addChildComponent(&position);
         addChildComponent(&polyphony);
+        addChildComponent(&cycleLength);
+        addChildComponent(&pattern);
         addChildComponent(&midiInPort);
         addChildComponent(&midiOutPort);
         addChildComponent(&description);
@@ -87,7 +89,7 @@ private:
     /// @param width The number of characters to display on each line.
     /// @param polyphony The number of notes being broadcast.
 
-    const std::string computePolyphonyString(uint8_t width, uint8_t polyphony) const noexcept;
+    const std::string computePolyphonyString(uint8_t width, uint16_t polyphony) const noexcept;
     
     /// @brief Layout the position of each child component.
 
@@ -96,6 +98,8 @@ private:
 private:
     Label position           = {"-x-"};
     Label polyphony          = {"........\n........"};
+    Label cycleLength        = {"Loop: -"};
+    Label pattern            = {"Pattern: 1"};
     Label midiInPort         = {"I: -"};
     Label midiOutPort        = {"O: -"};
     Label description        = {""};
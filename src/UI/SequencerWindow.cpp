@@ -112,6 +112,8 @@ void SequencerWindow::keyPressed(int key) noexcept
         case K_Enter:       { sequencer.toggleSelectedPlayhead();    return; }
         case K_BSlash:      { sequencer.toggleSelectPlayheadsMode(); return; }
         case K_Pipe:        { sequencer.selectNextPlayhead();        return; }
+        case K_RAngBracket: { sequencer.cycleSelectedPlayheadMultiplier(); return; }
+        case K_LAngBracket: { sequencer.cycleSelectedPlayheadDivider();    return; }
 
         default: return;
     }
@@ -36,7 +36,7 @@ struct UIPoint
         this->y = y;
     }
     
-    inline bool operator == (const UIPoint<T>& q)
+    inline bool operator == (const UIPoint<T>& q) const
     {
         return x == q.x && y == q.y;
     }
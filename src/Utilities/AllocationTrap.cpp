@@ -0,0 +1,147 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#include "AllocationTrap.h"
+
+#ifndef NDEBUG
+
+#include <new>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+/// @brief The number of AllocationTraps held by the current thread.
+/// @note  This is trivially initialised so that accessing it never allocates memory.
+
+static thread_local int traps = 0;
+
+/// @brief Abort the program if the current thread holds an AllocationTrap.
+/// @param operation A description of the operation that was attempted.
+
+static void trap(const char* operation) noexcept
+{
+    if (traps > 0)
+    {
+        traps = 0;
+        std::fprintf(stderr, "[AllocationTrap] %s inside a real-time scope.\n", operation);
+        std::abort();
+    }
+}
+
+bool AllocationTrap::isArmed() noexcept
+{
+    return traps > 0;
+}
+
+void AllocationTrap::arm() noexcept
+{
+    traps = traps + 1;
+}
+
+void AllocationTrap::disarm() noexcept
+{
+    traps = traps - 1;
+}
+
+// MARK: - Replacement allocation functions
+
+void* operator new(std::size_t size)
+{
+    trap("Allocation");
+
+    if (void* pointer = std::malloc(size > 0 ? size : 1))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    trap("Allocation");
+
+    return std::malloc(size > 0 ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    trap("Allocation");
+
+    void* pointer = nullptr;
+    const std::size_t bytes = size > 0 ? size : 1;
+    const std::size_t align = std::max(static_cast<std::size_t>(alignment), sizeof(void*));
+
+    if (posix_memalign(&pointer, align, bytes) == 0)
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        trap("Deallocation");
+
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    operator delete(pointer);
+}
+
+#endif
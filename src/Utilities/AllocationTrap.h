@@ -0,0 +1,55 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef ALLOCATIONTRAP_H
+#define ALLOCATIONTRAP_H
+
+/// @brief A scope in which the current thread must not allocate or free memory.
+/// @note  In debug builds, where `NDEBUG` is not defined, the global allocation functions are replaced and
+///        any allocation or deallocation made by a thread that holds an AllocationTrap aborts the program.
+///        In release builds, an AllocationTrap does nothing.
+
+class AllocationTrap
+{
+public:
+    AllocationTrap() noexcept
+    {
+        arm();
+    }
+    
+    ~AllocationTrap() noexcept
+    {
+        disarm();
+    }
+    
+    AllocationTrap(const AllocationTrap&) = delete;
+    AllocationTrap& operator = (const AllocationTrap&) = delete;
+
+public:
+    /// @brief Indicate whether the current thread holds an AllocationTrap or not.
+
+#ifndef NDEBUG
+    static bool isArmed() noexcept;
+#else
+    inline static bool isArmed() noexcept { return false; }
+#endif
+    
+private:
+    /// @brief Arm the trap on the current thread.
+
+#ifndef NDEBUG
+    static void arm() noexcept;
+#else
+    inline static void arm() noexcept {}
+#endif
+    
+    /// @brief Disarm the trap on the current thread.
+
+#ifndef NDEBUG
+    static void disarm() noexcept;
+#else
+    inline static void disarm() noexcept {}
+#endif
+};
+
+#endif
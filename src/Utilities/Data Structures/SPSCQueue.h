@@ -0,0 +1,94 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/// @brief A wait-free queue with a fixed capacity for passing elements from one thread to another.
+/// @note  `enqueue` must only be called by a single producer thread and `dequeue` by a single consumer thread.
+
+template <typename T, unsigned int N>
+class SPSCQueue
+{
+public:
+    SPSCQueue()
+    {
+        
+    }
+    
+public:
+    /// @brief Indicate whether the queue is empty or not.
+
+    inline bool empty() const noexcept
+    {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+    
+    /// @brief Indicate whether the queue contains elements or not.
+
+    inline bool isNotEmpty() const noexcept
+    {
+        return !empty();
+    }
+    
+    /// @brief Return the number of elements in the queue.
+    /// @note  The result is approximate when either thread is modifying the queue.
+
+    inline size_t size() const noexcept
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+    
+public:
+    /// @brief Enqueue a new element from the producer thread.
+    /// @param element The element to be enqueued.
+    /// @return A Boolean value to indicate whether the element was added to the queue or not.
+
+    bool enqueue(T element) noexcept
+    {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        
+        if (t - head.load(std::memory_order_acquire) == N)
+            return false;
+        
+        queue[t % N] = std::move(element);
+        tail.store(t + 1, std::memory_order_release);
+        
+        return true;
+    }
+    
+    /// @brief Dequeue an element from the consumer thread.
+    /// @param element The destination of the dequeued element.
+    /// @return A Boolean value to indicate whether an element was dequeued or not.
+
+    bool dequeue(T& element) noexcept
+    {
+        const size_t h = head.load(std::memory_order_relaxed);
+        
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        
+        element = std::move(queue[h % N]);
+        head.store(h + 1, std::memory_order_release);
+        
+        return true;
+    }
+    
+private:
+    /// @brief The number of elements that have been dequeued, which is written by the consumer thread.
+
+    alignas(64) std::atomic<size_t> head = {0};
+    
+    /// @brief The number of elements that have been enqueued, which is written by the producer thread.
+
+    alignas(64) std::atomic<size_t> tail = {0};
+    
+private:
+    std::array<T, N> queue;
+};
+
+#endif
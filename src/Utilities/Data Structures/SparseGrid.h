@@ -0,0 +1,531 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef SPARSEGRID_H
+#define SPARSEGRID_H
+
+#include <array>
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <stdexcept>
+
+/// @brief A sparse 2D grid of elements stored in square tiles, which are only allocated where the grid is occupied.
+/// @note  Each tile holds `TILE_SIZE * TILE_SIZE` cells and bitmaps of the occupied cells of each row and column. Tiles are found by position
+///        through an open-addressing hash table, so a lookup is O(1) regardless of the size of the grid, and the memory in use is
+///        proportional to the number of occupied tiles. Storage for a fixed number of tiles is reserved up front, so subsequent
+///        calls to `set` and `erase` never allocate memory. Elements keep their absolute positions, so the grid has no size.
+
+template <typename T>
+class SparseGrid
+{
+public:
+    /// @brief The number of rows and columns of each tile.
+
+    constexpr static unsigned int TILE_SIZE = 32;
+
+    /// @brief The greatest x- or y-coordinate that the grid can address.
+
+    constexpr static unsigned int MAXIMUM_COORDINATE = 0xFFFF;
+
+private:
+    constexpr static uint32_t Empty = 0xFFFFFFFF;
+
+public:
+    /// @brief Construct a grid with room for the given number of tiles.
+    /// @param capacity The greatest number of tiles that can be occupied at once.
+
+    SparseGrid(size_t capacity = 0)
+    {
+        reserve(capacity);
+    }
+
+    /// @brief Construct a copy of the given grid with the same capacity.
+
+    SparseGrid(const SparseGrid& other):
+    tiles(other.tiles), table(other.table), occupied(other.occupied), available(other.available),
+    recent(other.recent), numberOfElements(other.numberOfElements)
+    {
+        occupied.reserve(tiles.size());
+        available.reserve(tiles.size());
+    }
+
+    SparseGrid& operator = (const SparseGrid&) = delete;
+
+public:
+    /// @brief Reserve storage for the given number of tiles.
+    /// @param capacity The greatest number of tiles that can be occupied at once.
+    /// @note  Any existing contents are discarded.
+
+    inline void reserve(size_t capacity) noexcept(false)
+    {
+        size_t slots = 1;
+
+        while (slots < capacity * 2)
+        {
+            slots = slots * 2;
+        }
+
+        tiles.clear();
+        tiles.resize(capacity);
+        table.assign(slots, {Empty, 0});
+        occupied.clear();
+        occupied.reserve(capacity);
+        available.clear();
+        available.reserve(capacity);
+
+        for (size_t k = capacity; k > 0; --k)
+        {
+            available.push_back(static_cast<uint32_t>(k - 1));
+        }
+
+        numberOfElements = 0;
+        recent = {Empty, 0};
+    }
+
+    /// @brief Remove every element from the grid without releasing any storage.
+
+    inline void clear() noexcept
+    {
+        for (const uint32_t index : occupied)
+        {
+            available.push_back(index);
+        }
+
+        occupied.clear();
+        std::fill(table.begin(), table.end(), Slot {Empty, 0});
+
+        numberOfElements = 0;
+        recent = {Empty, 0};
+    }
+
+public:
+    /// @brief Set the contents of the grid at the given position.
+    /// @param element The element to be stored in the grid.
+    /// @param x The x-coordinate of the position.
+    /// @param y The y-coordinate of the position.
+    /// @throw An exception will be thrown if the position is out of range or if every tile is occupied.
+
+    inline void set(const T& element, unsigned int x, unsigned int y) noexcept(false)
+    {
+        if (x > MAXIMUM_COORDINATE || y > MAXIMUM_COORDINATE)
+        {
+            constexpr auto error = "The given position is out of range.";
+            throw std::out_of_range(error);
+        }
+
+        Tile * tile = locate(x, y);
+
+        if (tile == nullptr)
+        {
+            tile = allocate(x, y);
+        }
+
+        const unsigned int u = x % TILE_SIZE;
+        const unsigned int v = y % TILE_SIZE;
+        const uint32_t bit = 1u << u;
+
+        if (!(tile->rows[v] & bit))
+        {
+            tile->rows[v] |= bit;
+            tile->columns[u] |= 1u << v;
+            tile->count = tile->count + 1;
+            numberOfElements = numberOfElements + 1;
+        }
+
+        tile->cells[v * TILE_SIZE + u] = element;
+    }
+
+    /// @brief Return the contents of the grid at the given position (or nullptr if the position is empty).
+    /// @param x The x-coordinate of the desired position.
+    /// @param y The y-coordinate of the desired position.
+    /// @note  Unlike the non-const overload, this doesn't remember the tile it located, so it can be called from several threads at once
+    ///        as long as the grid isn't modified.
+
+    inline const T* get(unsigned int x, unsigned int y) const noexcept
+    {
+        const Tile * tile = locate(x, y);
+
+        if (tile == nullptr)
+            return nullptr;
+
+        const unsigned int u = x % TILE_SIZE;
+        const unsigned int v = y % TILE_SIZE;
+
+        if (!(tile->rows[v] & (1u << u)))
+            return nullptr;
+
+        return &(tile->cells[v * TILE_SIZE + u]);
+    }
+
+    inline T* get(unsigned int x, unsigned int y) noexcept
+    {
+        Tile * tile = locate(x, y);
+
+        if (tile == nullptr)
+            return nullptr;
+
+        const unsigned int u = x % TILE_SIZE;
+        const unsigned int v = y % TILE_SIZE;
+
+        if (!(tile->rows[v] & (1u << u)))
+            return nullptr;
+
+        return &(tile->cells[v * TILE_SIZE + u]);
+    }
+
+    /// @brief Erase the contents of the grid at the given position.
+    /// @param x The x-coordinate of the desired position.
+    /// @param y The y-coordinate of the desired position.
+    /// @return The element that was erased, which is moved out of the grid so that the caller can decide where it's destroyed.
+    /// @throw An exception will be thrown if the given position is empty.
+
+    inline T erase(unsigned int x, unsigned int y) noexcept(false)
+    {
+        Tile * tile = locate(x, y);
+
+        const unsigned int u = x % TILE_SIZE;
+        const unsigned int v = y % TILE_SIZE;
+        const uint32_t bit = 1u << u;
+
+        if (tile == nullptr || !(tile->rows[v] & bit))
+        {
+            constexpr auto error = "The given position is empty.";
+            throw std::out_of_range(error);
+        }
+
+        T element = std::move(tile->cells[v * TILE_SIZE + u]);
+
+        tile->rows[v] &= ~bit;
+        tile->columns[u] &= ~(1u << v);
+        tile->count = tile->count - 1;
+        numberOfElements = numberOfElements - 1;
+
+        if (tile->count == 0)
+        {
+            release(tile);
+        }
+
+        return element;
+    }
+
+    /// @brief Indicate whether the grid contains an element at the given position.
+    /// @param x The x-coordinate of the desired position.
+    /// @param y The y-coordinate of the desired position.
+
+    inline bool contains(unsigned int x, unsigned int y) const noexcept
+    {
+        return get(x, y) != nullptr;
+    }
+
+    /// @brief Find the first occupied cell along a straight or diagonal line from the given position.
+    /// @param x The x-coordinate of the position from which to search, which is not examined.
+    /// @param y The y-coordinate of the position from which to search, which is not examined.
+    /// @param dx The step along the x-axis, which must be -1, 0, or +1.
+    /// @param dy The step along the y-axis, which must be -1, 0, or +1.
+    /// @param length The number of cells to examine, which must not leave the range of the grid.
+    /// @return The number of steps to the first occupied cell, or zero if none of the examined cells is occupied.
+    /// @note  Unoccupied tiles are skipped in one step, and each occupied tile is searched by bit scanning its
+    ///        row or column bitmaps, so a row or column is searched at a cost of one lookup per tile.
+
+    inline unsigned int scan(unsigned int x, unsigned int y, int dx, int dy, unsigned int length) const noexcept
+    {
+        unsigned int k = 1;
+
+        while (k <= length)
+        {
+            const unsigned int cx = x + k * dx;
+            const unsigned int cy = y + k * dy;
+            const unsigned int u  = cx % TILE_SIZE;
+            const unsigned int v  = cy % TILE_SIZE;
+
+            // The number of cells along the line from (cx, cy) to the edge of its tile, which are examined together.
+
+            unsigned int span = length - k + 1;
+
+            if (dx > 0) span = std::min(span, TILE_SIZE - u);
+            if (dx < 0) span = std::min(span, u + 1);
+            if (dy > 0) span = std::min(span, TILE_SIZE - v);
+            if (dy < 0) span = std::min(span, v + 1);
+
+            if (const Tile * tile = locate(cx, cy))
+            {
+                if (dx == 0 || dy == 0)
+                {
+                    const uint32_t line = dy == 0 ? tile->rows[v] : tile->columns[u];
+                    const unsigned int w = dy == 0 ? u : v;
+                    const int step = dx + dy;
+
+                    if (step > 0)
+                    {
+                        const uint32_t bits = (line >> w) & (span < 32 ? (1u << span) - 1 : 0xFFFFFFFF);
+                        if (bits != 0) return k + __builtin_ctz(bits);
+                    }
+
+                    else
+                    {
+                        const uint32_t bits = (line << (31 - w)) & (0xFFFFFFFF << (32 - span));
+                        if (bits != 0) return k + __builtin_clz(bits);
+                    }
+                }
+
+                else for (unsigned int i = 0; i < span; ++i)
+                {
+                    if ((tile->rows[v + i * dy] >> (u + i * dx)) & 1)
+                        return k + i;
+                }
+            }
+
+            k = k + span;
+        }
+
+        return 0;
+    }
+
+    /// @brief Return the number of elements in the grid.
+
+    inline size_t size() const noexcept
+    {
+        return numberOfElements;
+    }
+
+    /// @brief Return the number of tiles that are occupied.
+
+    inline size_t getNumberOfTiles() const noexcept
+    {
+        return occupied.size();
+    }
+
+    /// @brief Indicate whether an element can be placed at the given position without exceeding the grid's capacity.
+    /// @param x The x-coordinate of the desired position.
+    /// @param y The y-coordinate of the desired position.
+
+    inline bool hasRoomFor(unsigned int x, unsigned int y) const noexcept
+    {
+        if (x > MAXIMUM_COORDINATE || y > MAXIMUM_COORDINATE)
+            return false;
+
+        return !available.empty() || locate(x, y) != nullptr;
+    }
+
+    /// @brief Pass each element of the grid and its position to the given callable, one tile at a time.
+    /// @param callback A callable object that accepts an element and its x- and y-coordinates.
+
+    template <typename Callback>
+    inline void forEach(Callback && callback) const
+    {
+        for (const uint32_t index : occupied)
+        {
+            const Tile & tile = tiles[index];
+            const unsigned int x = (tile.key >> 16) * TILE_SIZE;
+            const unsigned int y = (tile.key & 0xFFFF) * TILE_SIZE;
+
+            for (unsigned int v = 0; v < TILE_SIZE; ++v)
+            {
+                for (uint32_t row = tile.rows[v]; row != 0; row = row & (row - 1))
+                {
+                    const unsigned int u = __builtin_ctz(row);
+
+                    callback(tile.cells[v * TILE_SIZE + u], x + u, y + v);
+                }
+            }
+        }
+    }
+
+private:
+    /// @brief A square region of the grid.
+
+    struct Tile
+    {
+        std::array<T, TILE_SIZE * TILE_SIZE> cells;
+
+        /// @brief The occupancy bitmap of each row of the tile, where bit `u` of `rows[v]` represents the cell at (u, v).
+
+        std::array<uint32_t, TILE_SIZE> rows {};
+
+        /// @brief The occupancy bitmap of each column of the tile, where bit `v` of `columns[u]` represents the cell at (u, v).
+
+        std::array<uint32_t, TILE_SIZE> columns {};
+
+        /// @brief The packed coordinates of the tile.
+
+        uint32_t key = 0;
+
+        /// @brief The index of the tile in the list of occupied tiles.
+
+        uint32_t position = 0;
+
+        /// @brief The number of occupied cells.
+
+        uint16_t count = 0;
+    };
+
+    /// @brief An entry in the hash table, which maps a tile's packed coordinates to its index in the pool of tiles.
+
+    struct Slot
+    {
+        uint32_t key;
+        uint32_t tile;
+    };
+
+    /// @brief Compute the packed coordinates of the tile that contains the given position.
+
+    inline static uint32_t key(unsigned int x, unsigned int y) noexcept
+    {
+        return ((x / TILE_SIZE) << 16) | (y / TILE_SIZE);
+    }
+
+    /// @brief Compute the index of the hash table slot at which the search for the given key should begin.
+
+    inline size_t hash(uint32_t key) const noexcept
+    {
+        return static_cast<size_t>((key * 0x9E3779B1u) >> 7) & (table.size() - 1);
+    }
+
+    /// @brief Return the hash table entry of the tile that contains the given position, or an empty entry if the tile is unoccupied.
+
+    inline Slot probe(unsigned int x, unsigned int y) const noexcept
+    {
+        if (x > MAXIMUM_COORDINATE || y > MAXIMUM_COORDINATE || occupied.empty())
+            return {Empty, 0};
+
+        const uint32_t k = key(x, y);
+
+        // Successive lookups tend to fall in the same tile, since playheads move one cell at a time.
+
+        if (k == recent.key)
+        {
+            return recent;
+        }
+
+        for (size_t slot = hash(k);; slot = (slot + 1) & (table.size() - 1))
+        {
+            if (table[slot].key == k)     return table[slot];
+            if (table[slot].key == Empty) return {Empty, 0};
+        }
+    }
+
+    /// @brief Return the tile that contains the given position, or nullptr if the tile is unoccupied, and remember the tile for the next lookup.
+
+    inline Tile* locate(unsigned int x, unsigned int y) noexcept
+    {
+        const Slot slot = probe(x, y);
+
+        if (slot.key == Empty)
+            return nullptr;
+
+        recent = slot;
+        return &(tiles[slot.tile]);
+    }
+
+    /// @brief Return the tile that contains the given position, or nullptr if the tile is unoccupied.
+
+    inline const Tile* locate(unsigned int x, unsigned int y) const noexcept
+    {
+        const Slot slot = probe(x, y);
+
+        return slot.key == Empty ? nullptr : &(tiles[slot.tile]);
+    }
+
+    /// @brief Take an unused tile from the pool and assign it the tile coordinates of the given position.
+    /// @throw An exception will be thrown if every tile is occupied.
+
+    inline Tile* allocate(unsigned int x, unsigned int y) noexcept(false)
+    {
+        if (available.empty())
+        {
+            constexpr auto error = "Every tile of the grid is occupied.";
+            throw std::length_error(error);
+        }
+
+        const uint32_t index = available.back();
+        available.pop_back();
+
+        Tile & tile = tiles[index];
+        tile.key = key(x, y);
+        tile.rows.fill(0);
+        tile.columns.fill(0);
+        tile.count = 0;
+        tile.position = static_cast<uint32_t>(occupied.size());
+        occupied.push_back(index);
+
+        size_t slot = hash(tile.key);
+
+        while (table[slot].key != Empty)
+        {
+            slot = (slot + 1) & (table.size() - 1);
+        }
+
+        table[slot] = {tile.key, index};
+
+        return &tile;
+    }
+
+    /// @brief Return the given empty tile to the pool and remove it from the hash table.
+
+    inline void release(Tile* tile) noexcept
+    {
+        const uint32_t index = static_cast<uint32_t>(tile - tiles.data());
+        const uint32_t moved = occupied.back();
+
+        occupied[tile->position] = moved;
+        tiles[moved].position = tile->position;
+        occupied.pop_back();
+        available.push_back(index);
+
+        const size_t mask = table.size() - 1;
+        size_t slot = hash(tile->key);
+
+        while (table[slot].key != tile->key)
+        {
+            slot = (slot + 1) & mask;
+        }
+
+        // Subsequent entries of the same cluster are shifted backwards, so no search can end early at the emptied slot.
+
+        for (size_t next = (slot + 1) & mask; table[next].key != Empty; next = (next + 1) & mask)
+        {
+            const size_t home = hash(table[next].key);
+            const bool isReachable = slot <= next ? (home <= slot || home > next) : (home <= slot && home > next);
+
+            if (isReachable)
+            {
+                table[slot] = table[next];
+                slot = next;
+            }
+        }
+
+        table[slot] = {Empty, 0};
+        recent = {Empty, 0};
+    }
+
+private:
+    /// @brief The pool of tiles.
+
+    std::vector<Tile> tiles;
+
+    /// @brief The hash table that maps each occupied tile's coordinates to its index in the pool.
+
+    std::vector<Slot> table;
+
+    /// @brief The indices of the occupied tiles.
+
+    std::vector<uint32_t> occupied;
+
+    /// @brief The indices of the unoccupied tiles.
+
+    std::vector<uint32_t> available;
+
+    /// @brief The hash table entry of the most recently located tile.
+
+    Slot recent = {Empty, 0};
+
+    size_t numberOfElements = 0;
+};
+
+template <typename T> constexpr unsigned int SparseGrid<T>::TILE_SIZE;
+template <typename T> constexpr unsigned int SparseGrid<T>::MAXIMUM_COORDINATE;
+template <typename T> constexpr uint32_t SparseGrid<T>::Empty;
+
+#endif
@@ -0,0 +1,94 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/// @brief A wait-free triple buffer for passing the latest version of a large object from one thread to another.
+/// @note  The writer fills the back buffer and publishes it by swapping it with the middle buffer, and the reader takes the
+///        middle buffer by swapping it with the front buffer, so neither thread ever waits for the other or copies the object twice.
+///        Versions that are published before the reader takes them are superseded. `getWriteBuffer`, `publish`, and `isConsumed`
+///        must only be called by a single writer thread and `update` and `getReadBuffer` by a single reader thread.
+
+template <typename T>
+class TripleBuffer
+{
+public:
+    /// @brief Construct each of the three buffers with the given arguments.
+
+    template <typename ... Arguments>
+    TripleBuffer(const Arguments & ... arguments):
+    buffers {T(arguments...), T(arguments...), T(arguments...)}
+    {
+        
+    }
+
+public:
+    /// @brief Return the buffer that the writer should fill.
+
+    inline T& getWriteBuffer() noexcept
+    {
+        return buffers[back];
+    }
+
+    /// @brief Publish the buffer that the writer filled as the latest version.
+
+    inline void publish() noexcept
+    {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    /// @brief Indicate whether the reader has taken the most recently published version.
+    /// @note  A writer can skip its work until this is true, since a version the reader never takes is wasted.
+
+    inline bool isConsumed() const noexcept
+    {
+        return (middle.load(std::memory_order_acquire) & FRESH) == 0;
+    }
+
+public:
+    /// @brief Take the most recently published version if the reader hasn't already taken it.
+    /// @return A Boolean value to indicate whether the read buffer holds a new version or not.
+
+    inline bool update() noexcept
+    {
+        if ((middle.load(std::memory_order_relaxed) & FRESH) == 0)
+            return false;
+
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+
+        return true;
+    }
+
+    /// @brief Return the buffer that the reader should read.
+
+    inline const T& getReadBuffer() const noexcept
+    {
+        return buffers[front];
+    }
+
+private:
+    constexpr static uint8_t INDEX = 0x3;
+    constexpr static uint8_t FRESH = 0x4;
+
+private:
+    std::array<T, 3> buffers;
+
+    /// @brief The index of the middle buffer, and whether it holds a version the reader hasn't taken.
+
+    std::atomic<uint8_t> middle = {1};
+
+    /// @brief The index of the writer's buffer.
+
+    uint8_t back = 0;
+
+    /// @brief The index of the reader's buffer.
+
+    uint8_t front = 2;
+};
+
+#endif
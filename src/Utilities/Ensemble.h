@@ -42,6 +42,11 @@
 #include "MIDIServer.h"
 #include "MIDITypes.h"
 
+// Sequencer engine
+// ================
+
+#include "EngineTypes.h"
+
 // Sequencer nodes
 // ===============
 
@@ -49,7 +54,9 @@
 
 // Data structures
 // ===============
-#include "Table.h"
+#include "SparseGrid.h"
 #include "CircularQueue.h"
+#include "SPSCQueue.h"
+#include "TripleBuffer.h"
 
 #endif
@@ -0,0 +1,89 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/// @brief A read-only view of a file's contents mapped into memory.
+/// @note  The file is paged in by the virtual memory system as its contents are read, so nothing is copied into an intermediate
+///        buffer, and the contents can be read in place as long as the view exists. The view is unmapped when it's destroyed.
+
+class MappedFile
+{
+public:
+    /// @brief Map the file at the given path into memory.
+    /// @param path The path of the file, which must not be modified while it's mapped.
+    /// @note  The view is empty if the file can't be opened or mapped, or if the file is empty.
+
+    MappedFile(const std::string& path) noexcept
+    {
+        const int descriptor = open(path.c_str(), O_RDONLY);
+
+        if (descriptor < 0)
+        {
+            return;
+        }
+
+        struct stat status;
+
+        if (fstat(descriptor, &status) == 0 && status.st_size > 0)
+        {
+            void * address = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+            if (address != MAP_FAILED)
+            {
+                bytes  = static_cast<const uint8_t*>(address);
+                length = static_cast<size_t>(status.st_size);
+            }
+        }
+
+        close(descriptor);
+    }
+
+    ~MappedFile()
+    {
+        if (bytes != nullptr)
+        {
+            munmap(const_cast<uint8_t*>(bytes), length);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator = (const MappedFile&) = delete;
+
+public:
+    /// @brief Indicate whether the file was mapped successfully or not.
+
+    inline bool isOpen() const noexcept
+    {
+        return bytes != nullptr;
+    }
+
+    /// @brief Return the first byte of the file, which is aligned to the system's page size.
+
+    inline const uint8_t* data() const noexcept
+    {
+        return bytes;
+    }
+
+    /// @brief Return the size of the file in bytes.
+
+    inline size_t size() const noexcept
+    {
+        return length;
+    }
+
+private:
+    const uint8_t * bytes = nullptr;
+    size_t length = 0;
+};
+
+#endif
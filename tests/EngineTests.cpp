@@ -0,0 +1,495 @@
+//  Ensemble
+//  Created by David Spry on 17/10/26.
+
+#include <cstdio>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include "AllocationTrap.h"
+#include "SequencerBank.hpp"
+#include "SequencerEngine.hpp"
+#include "SequencerRenderer.hpp"
+
+/// @brief The number of checks that have failed.
+
+static int failures = 0;
+
+#define CHECK(condition)                                                       \
+    do                                                                         \
+    {                                                                          \
+        if (!(condition))                                                      \
+        {                                                                      \
+            std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #condition); \
+            failures = failures + 1;                                           \
+        }                                                                      \
+    }                                                                          \
+    while (false)
+
+// MARK: - Fixtures
+
+/// @brief Return the next value of a small deterministic generator, so that each test builds the same grid.
+
+static uint32_t next(uint32_t& state) noexcept
+{
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+/// @brief Fill the given engine with a grid of nodes and notes and the given number of playheads.
+/// @param engine The engine to be filled.
+/// @param playheads The number of playheads to be placed.
+/// @param seed The seed of the grid's layout.
+
+static void populate(SequencerEngine& engine, int playheads, uint32_t seed) noexcept
+{
+    constexpr int COLUMNS = 64;
+    constexpr int ROWS    = 64;
+
+    const MIDISettings settings;
+
+    SequencerCommand command;
+    command.type = SequencerCommand::Resize;
+    command.xy   = {COLUMNS, ROWS};
+    engine.apply(command);
+
+    for (int k = 0; k < COLUMNS * ROWS / 4; ++k)
+    {
+        command = SequencerCommand();
+        command.xy = {static_cast<int>(next(seed) % COLUMNS), static_cast<int>(next(seed) % ROWS)};
+
+        switch (next(seed) % 4)
+        {
+            case 0:  command.type = SequencerCommand::PlaceNote;
+                     command.note = MIDINote(static_cast<uint8_t>(next(seed) % 12), settings); break;
+            case 1:  command.type = SequencerCommand::PlacePortal; break;
+            default: command.type = SequencerCommand::PlaceNode;
+                     command.redirection = static_cast<Redirection>(next(seed) % 5); break;
+        }
+
+        engine.apply(command);
+    }
+
+    const UIPoint<int> directions[] = {{1, 0}, {0, 1}, {-1, 0}, {0, -1}, {1, 1}, {-1, 1}};
+
+    for (int k = 0; k < playheads; ++k)
+    {
+        command = SequencerCommand();
+        command.type  = SequencerCommand::PlacePlayhead;
+        command.xy    = {static_cast<int>(next(seed) % COLUMNS), static_cast<int>(next(seed) % ROWS)};
+        command.delta = directions[next(seed) % 6];
+        engine.apply(command);
+    }
+}
+
+// MARK: - Tests
+
+/// @brief Simulate and dispatch ticks with the allocation trap armed, as the clock's thread does, and apply edits between ticks.
+/// @param threads The number of threads that resolve the playheads' paths.
+/// @param playheads The number of playheads, which decides whether the paths are resolved in parallel.
+/// @note  The program is aborted by the trap if the engine allocates or frees memory.
+
+static void testRealTimeTicks(size_t threads, int playheads)
+{
+    EngineWorkers workers(threads);
+    SequencerEngine engine(workers);
+
+    populate(engine, playheads, static_cast<uint32_t>(threads * 7919 + playheads));
+
+    uint64_t notes = 0;
+    uint32_t seed  = 1;
+
+    {
+        const AllocationTrap trap;
+
+        CHECK(AllocationTrap::isArmed());
+
+        for (int tick = 0; tick < 2048; ++tick)
+        {
+            // An edit is applied every so often, as a command would be between ticks, which invalidates the simulated ticks.
+
+            if (tick % 97 == 0)
+            {
+                SequencerCommand command;
+                command.type        = SequencerCommand::PlaceNode;
+                command.xy          = {static_cast<int>(next(seed) % 64), static_cast<int>(next(seed) % 64)};
+                command.redirection = Redirection::Alternating;
+                engine.apply(command);
+            }
+
+            engine.simulate(1);
+            engine.dispatch([&](const MIDINote&, uint16_t) { notes = notes + 1; });
+            engine.simulate(8);
+        }
+    }
+
+    CHECK(engine.getPosition() == 2048);
+    CHECK(notes > 0);
+}
+
+/// @brief Play the given number of ticks with the allocation trap armed and return a hash of the notes that were dispatched.
+
+static uint64_t play(SequencerEngine& engine, int ticks) noexcept
+{
+    uint64_t hash = 1469598103934665603ull;
+
+    const AllocationTrap trap;
+
+    for (int tick = 0; tick < ticks; ++tick)
+    {
+        engine.simulate(4);
+        engine.dispatch([&](const MIDINote& note, uint16_t offset)
+        {
+            hash = (hash ^ (note.note * 1024u + offset)) * 1099511628211ull;
+        });
+    }
+
+    return hash;
+}
+
+/// @brief Check that a resize to an invalid size is discarded by the engine rather than reported by throwing, since an edit is
+///        applied by the clock's thread, where throwing would allocate the exception.
+
+static void testInvalidResize()
+{
+    EngineWorkers workers(1);
+    SequencerEngine engine(workers);
+
+    populate(engine, 16, 13);
+
+    const AllocationTrap trap;
+
+    for (const UIPoint<int> size : {UIPoint<int>{0, 8}, UIPoint<int>{8, -1}, UIPoint<int>{SequencerEngine::MAXIMUM_GRID_SIZE + 1, 8}})
+    {
+        SequencerCommand command;
+        command.type = SequencerCommand::Resize;
+        command.xy   = size;
+        engine.apply(command);
+
+        CHECK(engine.getGridSize().w == 64);
+        CHECK(engine.getGridSize().h == 64);
+    }
+}
+
+/// @brief Check that the music doesn't depend on the number of threads that resolve the playheads' paths.
+
+static void testThreadIndependence()
+{
+    EngineWorkers one(1);
+    EngineWorkers four(4);
+
+    SequencerEngine serial(one);
+    SequencerEngine parallel(four);
+
+    populate(serial,   512, 42);
+    populate(parallel, 512, 42);
+
+    CHECK(play(serial, 512) == play(parallel, 512));
+}
+
+/// @brief Check that engines that share a pool of threads can be simulated by different threads at once,
+///        e.g., the active pattern by the clock's thread and a pattern that's being loaded by the UI thread.
+
+static void testSharedWorkers()
+{
+    EngineWorkers one(1);
+    EngineWorkers four(4);
+
+    SequencerEngine reference(one);
+    SequencerEngine engines[] = {SequencerEngine(four), SequencerEngine(four)};
+
+    populate(reference,  512, 7);
+    populate(engines[0], 512, 7);
+    populate(engines[1], 512, 7);
+
+    uint64_t hashes[2] = {0, 0};
+
+    std::thread other([&]() { hashes[1] = play(engines[1], 512); });
+    hashes[0] = play(engines[0], 512);
+    other.join();
+
+    const uint64_t expected = play(reference, 512);
+
+    CHECK(hashes[0] == expected);
+    CHECK(hashes[1] == expected);
+}
+
+/// @brief Check that releasing an engine's lookahead part way through, as the bank does when a pattern stops being played,
+///        and reserving it again doesn't change the music.
+
+static void testReleasedLookahead()
+{
+    EngineWorkers workers(4);
+
+    SequencerEngine reference(workers);
+    SequencerEngine released(workers);
+
+    populate(reference, 512, 11);
+    populate(released,  512, 11);
+
+    // The lookahead is released while ticks are simulated ahead, so the simulation must be rewound to the last dispatched tick.
+
+    uint64_t hashes[2] = {play(reference, 100), play(released, 100)};
+
+    reference.simulate(8);
+    released.simulate(8);
+    released.releaseLookahead();
+    released.simulate(8);
+
+    CHECK(released.getNumberOfSimulatedTicks() == 0);
+
+    released.reserveLookahead();
+
+    hashes[0] = hashes[0] ^ play(reference, 400);
+    hashes[1] = hashes[1] ^ play(released,  400);
+
+    CHECK(hashes[0] == hashes[1]);
+    CHECK(reference.getPosition() == released.getPosition());
+}
+
+/// @brief Play the bank's active pattern for one tick with the allocation trap armed, as the clock's thread does.
+/// @return The transport's tick at which a queued switch was made, or zero if no switch was made.
+
+static uint64_t tick(SequencerBank& bank) noexcept
+{
+    const AllocationTrap trap;
+
+    const uint64_t transport = bank.getTransportTick();
+    const bool switched = bank.advance();
+
+    SequencerEngine & engine = bank.getActive();
+
+    engine.simulate(1);
+    engine.dispatch([](const MIDINote&, uint16_t) {});
+    engine.simulate(8);
+
+    return switched ? transport : 0;
+}
+
+/// @brief Check that queued patterns become active at boundaries of the bank's transport after the transport has been moved by
+///        a seek, and that a pattern that's switched in carries on the transport rather than its own stale position, so a bar
+///        quantised switch that follows a beat quantised switch still lands on a bar.
+
+static void testBankBoundaries()
+{
+    SequencerBank bank;
+
+    populate(bank.getActive(), 4, 3);
+
+    SequencerEngine * pattern = bank.getPattern(1);
+
+    pattern->reserveLookahead();
+    populate(*pattern, 4, 5);
+    pattern->simulate(8);
+
+    bank.getActive().seek(5);
+
+    CHECK(bank.getTransportTick() == 5);
+
+    // The first switch is quantised to a beat of two ticks.
+
+    CHECK(bank.queue(1, 2));
+
+    uint64_t first = 0;
+
+    while (first == 0 && bank.getTransportTick() < 64)
+    {
+        first = tick(bank);
+    }
+
+    CHECK(first == 6);
+    CHECK(bank.getActiveIndex() == 1);
+    CHECK(bank.getTransportTick() == 7);
+    CHECK(bank.getActive().getPosition() == 1);
+
+    // The second switch is quantised to a bar of eight ticks, which the previous pattern's stale position mustn't shift.
+
+    bank.getPattern(0)->reserveLookahead();
+    bank.getPattern(0)->simulate(8);
+
+    CHECK(bank.queue(0, 8));
+
+    uint64_t second = 0;
+
+    while (second == 0 && bank.getTransportTick() < 64)
+    {
+        second = tick(bank);
+    }
+
+    CHECK(second == 8);
+    CHECK(bank.getActiveIndex() == 0);
+    CHECK(bank.getTransportTick() == 9);
+    CHECK(bank.getActive().getPosition() == 7);
+    CHECK(bank.getQueuedIndex() == SequencerBank::None);
+}
+
+/// @brief An event of a track chunk, with the number of bytes in which its delta time was encoded.
+
+struct TrackEvent
+{
+    uint32_t delta;
+    size_t   size;
+    uint8_t  status;
+    uint8_t  note;
+    uint8_t  velocity;
+};
+
+/// @brief Return the channel messages of the last track chunk of the given Standard MIDI File.
+
+static std::vector<TrackEvent> readLastTrack(const std::vector<uint8_t>& bytes)
+{
+    const auto integer = [&](size_t offset)
+    {
+        return static_cast<size_t>(bytes[offset]) << 24 | bytes[offset + 1] << 16 | bytes[offset + 2] << 8 | bytes[offset + 3];
+    };
+
+    size_t begin = 0;
+    size_t end   = 0;
+
+    for (size_t offset = 0; offset + 8 <= bytes.size(); offset = offset + 8 + integer(offset + 4))
+    {
+        begin = offset + 8;
+        end   = std::min(bytes.size(), begin + integer(offset + 4));
+    }
+
+    std::vector<TrackEvent> events;
+
+    for (size_t k = begin; k < end;)
+    {
+        TrackEvent event = {0, 0, 0, 0, 0};
+
+        do
+        {
+            event.delta = event.delta << 7 | (bytes[k] & 0x7F);
+            event.size  = event.size + 1;
+        }
+        while (bytes[k++] & 0x80);
+
+        // Meta events, i.e., the track's name and its end, are passed over.
+
+        if (bytes[k] == 0xFF)
+        {
+            k = k + 3 + bytes[k + 2];
+            continue;
+        }
+
+        event.status   = bytes[k];
+        event.note     = bytes[k + 1];
+        event.velocity = bytes[k + 2];
+        events.push_back(event);
+
+        k = k + 3;
+    }
+
+    return events;
+}
+
+/// @brief Check the bytes of a rendered file in which a note is retriggered in the tick that releases it and then falls silent
+///        for long enough that the renderer fast-forwards to the next cycle.
+
+static void testRenderedTrack()
+{
+    // The playhead moves down a column of 512 cells, landing on the same pitch on rows 3 and 11, so each note lasts exactly until
+    // the next begins, and then no note is held for the 496 ticks until the column repeats.
+
+    SequencerEngine engine;
+    engine.reserveLookahead();
+
+    const MIDISettings settings(3, 1, 8, 100);
+
+    SequencerCommand command;
+    command.type = SequencerCommand::Resize;
+    command.xy   = {2, 512};
+    engine.apply(command);
+
+    for (const int row : {3, 11})
+    {
+        command = SequencerCommand();
+        command.type = SequencerCommand::PlaceNote;
+        command.xy   = {0, row};
+        command.note = MIDINote(5, settings);
+        engine.apply(command);
+    }
+
+    command = SequencerCommand();
+    command.type  = SequencerCommand::PlacePlayhead;
+    command.xy    = {0, 0};
+    command.delta = {0, 1};
+    engine.apply(command);
+
+    MIDIFileWriter file;
+    SequencerRenderer renderer;
+
+    renderer.setTempo(120.0);
+    renderer.setTicksPerBeat(4);
+    renderer.render(engine, 40, file);
+
+    const char * path = "EngineTests.mid";
+
+    CHECK(file.save(path));
+
+    std::ifstream stream(path, std::ios::binary);
+    const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    stream.close();
+    std::remove(path);
+
+    CHECK(bytes.size() > 14 && std::equal(bytes.begin(), bytes.begin() + 4, "MThd"));
+
+    const std::vector<TrackEvent> events = readLastTrack(bytes);
+
+    // Each tick is a quarter of a beat of 960 pulses, so the notes are 1920 pulses apart and the silence lasts 119040 pulses.
+
+    const uint8_t pitch = MIDINote(5, settings).note;
+
+    CHECK(events.size() == 8);
+
+    if (events.size() != 8) return;
+
+    for (size_t cycle = 0; cycle < 2; ++cycle)
+    {
+        const TrackEvent * event = events.data() + cycle * 4;
+
+        CHECK(event[0].status == 0x90 && event[0].note == pitch && event[0].velocity == 100);
+        CHECK(event[1].status == 0x80 && event[1].note == pitch && event[1].delta == 1920 && event[1].size == 2);
+        CHECK(event[2].status == 0x90 && event[2].note == pitch && event[2].delta == 0    && event[2].size == 1);
+        CHECK(event[3].status == 0x80 && event[3].note == pitch && event[3].delta == 1920 && event[3].size == 2);
+    }
+
+    // The playhead reaches row 3 on the third tick, and both silences are fast-forwarded without shifting the notes that follow.
+
+    CHECK(events[0].delta == 480 && events[0].size == 2);
+    CHECK(events[4].delta == 119040 && events[4].size == 3);
+}
+
+int main()
+{
+    if (!AllocationTrap::isArmed())
+    {
+        const AllocationTrap trap;
+
+        if (!AllocationTrap::isArmed())
+        {
+            std::fprintf(stderr, "The allocation trap is disabled in builds that define NDEBUG.\n");
+            return 77;
+        }
+    }
+
+    testRealTimeTicks(1, 16);
+    testRealTimeTicks(4, 16);
+    testRealTimeTicks(4, 512);
+    testInvalidResize();
+    testThreadIndependence();
+    testSharedWorkers();
+    testReleasedLookahead();
+    testBankBoundaries();
+    testRenderedTrack();
+
+    if (failures > 0)
+    {
+        std::fprintf(stderr, "%d checks failed.\n", failures);
+        return 1;
+    }
+
+    return 0;
+}